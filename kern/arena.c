@@ -0,0 +1,231 @@
+/*****************************************************************************
+* (c) Copyright 2012-2013 F.Hoffmann-La Roche AG                             *
+* Contact: bioinfoc@bioinfoc.ch, Detlef.Wolf@Roche.com.                      *
+*                                                                            *
+* This file is part of BIOINFO-C. BIOINFO-C is free software: you can        *
+* redistribute it and/or modify it under the terms of the GNU Lesser         *
+* General Public License as published by the Free Software Foundation,       *
+* either version 3 of the License, or (at your option) any later version.    *
+*                                                                            *
+* BIOINFO-C is distributed in the hope that it will be useful, but           *
+* WITHOUT ANY WARRANTY; without even the implied warranty of                 *
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU          *
+* Lesser General Public License for more details. You should have            *
+* received a copy of the GNU Lesser General Public License along with        *
+* BIOINFO-C. If not, see <http://www.gnu.org/licenses/>.                     *
+*****************************************************************************/
+/** @file arena.c
+    @brief Module for region based memory allocation: many small objects
+    are carved out of a few large blocks and released all at once.
+    Module prefix arena_
+    Usage:<br>
+    Arena ar = arena_create (0);<br>
+    Texta t = textCreateIn (ar,10);<br>
+    textAddIn (ar,t,"probe1");<br>
+    ...<br>
+    arena_destroy (ar); // releases t and all its strings
+*/
+#include <string.h>
+
+#include "log.h"
+#include "hlrmisc.h"
+#include "arena.h"
+
+/// Default size of the blocks of an Arena
+#define ARENA_BLOCKSIZE (1024*1024)
+
+/// Alignment of all memory handed out, enough for any basic type
+#define ARENA_ALIGN 16
+
+/// Round 'n' up to a multiple of ARENA_ALIGN
+#define ARENA_ROUNDUP(n) (((n) + ARENA_ALIGN - 1) & ~(size_t)(ARENA_ALIGN - 1))
+
+/// Size of the block header, keeping the data behind it aligned
+#define ARENA_HEADER ARENA_ROUNDUP (sizeof (ArenaBlock))
+
+Arena arena_create (size_t blockSize) {
+  /**
+     Create an Arena.<br>
+     Postcondition: memory can be allocated with arena_alloc() etc.,
+     arena_destroy() releases all of it at once.
+     @param[in] blockSize - size of the blocks memory is carved from;
+                            0 means 1 MB
+     @return the Arena
+  */
+  Arena this1 = (Arena)hlr_calloc (1,sizeof (struct _arenaStruct_));
+  this1->blockSize = blockSize > 0 ? ARENA_ROUNDUP (blockSize) : ARENA_BLOCKSIZE;
+  return this1;
+}
+
+void arena_destroy_func (Arena this1) {
+  /**
+     Destroy the Arena and all memory allocated from it.<br>
+     Do not call this function but use the macro arena_destroy.
+     @param[in] this1 - the Arena, may be NULL
+  */
+  if (this1 == NULL)
+    return;
+  arena_clear (this1);
+  hlr_free (this1);
+}
+
+void arena_clear (Arena this1) {
+  /**
+     Release all memory allocated from the Arena, which stays usable.
+     Pointers obtained from it before are invalid afterwards.
+     @param[in] this1 - the Arena
+  */
+  ArenaBlock *b;
+
+  while ((b = this1->blocks) != NULL) {
+    this1->blocks = b->next;
+    hlr_free (b);
+  }
+  this1->cur = this1->end = NULL;
+  this1->bytes = 0;
+}
+
+static char *newBlock (Arena this1,size_t n) {
+  /**
+     Allocates a block with 'n' bytes of data and puts it into the
+     list of blocks
+     @return start of the data of the block
+  */
+  ArenaBlock *b = (ArenaBlock *)hlr_malloc (ARENA_HEADER + n);
+
+  b->next = this1->blocks;
+  this1->blocks = b;
+  return (char *)b + ARENA_HEADER;
+}
+
+void *arena_alloc (Arena this1,size_t n) {
+  /**
+     Allocate 'n' bytes from the Arena; the memory is aligned for any
+     basic type and must not be freed individually.
+     @param[in] this1 - the Arena
+     @param[in] n - number of bytes
+     @return pointer to the memory, not initialized
+  */
+  char *p;
+  ArenaBlock *b;
+
+  n = ARENA_ROUNDUP (n > 0 ? n : 1);
+  this1->bytes += n;
+  if (n <= (size_t)(this1->end - this1->cur)) {
+    p = this1->cur;
+    this1->cur += n;
+    return p;
+  }
+  if (n > this1->blockSize / 4) {
+    /* a large object gets a block of its own behind the current one,
+       so that the rest of the current block is not wasted */
+    p = newBlock (this1,n);
+    if ((b = this1->blocks->next) != NULL) {
+      this1->blocks->next = b->next;
+      b->next = this1->blocks;
+      this1->blocks = b;
+    }
+    return p;
+  }
+  p = newBlock (this1,this1->blockSize);
+  this1->cur = p + n;
+  this1->end = p + this1->blockSize;
+  return p;
+}
+
+void *arena_calloc (Arena this1,size_t nelem,size_t elsize) {
+  /**
+     Like arena_alloc(), but for 'nelem' elements of 'elsize' bytes,
+     all set to 0
+  */
+  void *p = arena_alloc (this1,nelem * elsize);
+
+  memset (p,0,nelem * elsize);
+  return p;
+}
+
+char *arena_strdup (Arena this1,char *s) {
+  /**
+     Copy a string into the Arena
+     @param[in] this1 - the Arena
+     @param[in] s - the string
+     @return the copy
+  */
+  size_t len = strlen (s) + 1;
+  char *p = (char *)arena_alloc (this1,len);
+
+  memcpy (p,s,len);
+  return p;
+}
+
+char *arena_strndup (Arena this1,char *s,int n) {
+  /**
+     Copy the first 'n' characters of 's' into the Arena; 's' need not
+     be '\0'-terminated
+     @param[in] this1 - the Arena
+     @param[in] s - start of the string
+     @param[in] n - number of characters
+     @return the '\0'-terminated copy
+  */
+  char *p = (char *)arena_alloc (this1,n + 1);
+
+  memcpy (p,s,n);
+  p[n] = '\0';
+  return p;
+}
+
+size_t arena_bytesGet (Arena this1) {
+  /**
+     @param[in] this1 - the Arena
+     @return number of bytes handed out by the Arena since its creation
+             or the last arena_clear()
+  */
+  return this1->bytes;
+}
+
+static void *arrayAlloc (void *arena,size_t n) {
+  /**
+     Allocation function registered with Arrays from uArrayCreateIn()
+  */
+  return arena_alloc ((Arena)arena,n);
+}
+
+Array uArrayCreateIn (Arena arena,int n,int size) {
+  /**
+     Create an Array of n elements having 'size' bytes in 'arena'.<br>
+     NOTE: Do not call this function in any program.
+           Use the macro arrayCreateIn() instead
+     @param[in] arena - the Arena
+     @param[in] n - initial number of elements;
+                    if n <=0, space for one element is allocated
+     @param[in] size - element size
+     @return new Array, each of its bytes initialized to 0
+  */
+  Array new1;
+
+  if (size <= 0)
+    die ("negative size %d in uArrayCreateIn",size);
+  if (n < 1)
+    n = 1;
+  new1 = (Array)arena_alloc (arena,sizeof (struct ArrayStruct));
+  new1->base = (char *)arena_calloc (arena,n,size);
+  new1->dim = n;
+  new1->max = 0;
+  new1->size = size;
+  new1->arena = arena;
+  new1->arenaAlloc = arrayAlloc;
+  return new1;
+}
+
+Stringa stringCreateIn (Arena arena,int initialSize) {
+  /**
+     Create an array of char in 'arena' and make it null-terminated,
+     the counterpart of stringCreate()
+     @param[in] arena - the Arena
+     @param[in] initialSize - the initial number of elements
+     @return the Array
+  */
+  Array a = arrayCreateIn (arena,initialSize,char);
+  array (a,0,char) = '\0';
+  return a;
+}
@@ -0,0 +1,98 @@
+/*****************************************************************************
+* (c) Copyright 2012-2013 F.Hoffmann-La Roche AG                             *
+* Contact: bioinfoc@bioinfoc.ch, Detlef.Wolf@Roche.com.                      *
+*                                                                            *
+* This file is part of BIOINFO-C. BIOINFO-C is free software: you can        *
+* redistribute it and/or modify it under the terms of the GNU Lesser         *
+* General Public License as published by the Free Software Foundation,       *
+* either version 3 of the License, or (at your option) any later version.    *
+*                                                                            *
+* BIOINFO-C is distributed in the hope that it will be useful, but           *
+* WITHOUT ANY WARRANTY; without even the implied warranty of                 *
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU          *
+* Lesser General Public License for more details. You should have            *
+* received a copy of the GNU Lesser General Public License along with        *
+* BIOINFO-C. If not, see <http://www.gnu.org/licenses/>.                     *
+*****************************************************************************/
+/** @file arena.h
+    @brief Module for region based memory allocation: many small objects
+    are carved out of a few large blocks and released all at once.
+    Module prefix arena_
+*/
+#ifndef ARENA_H
+#define ARENA_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stddef.h>
+#include "array.h"
+#include "format.h"
+
+/// Header of a memory block of an Arena - private
+typedef struct _arenaBlockStruct_ {
+  struct _arenaBlockStruct_ *next; //!< block allocated before this one
+} ArenaBlock;
+
+/**
+   The Arena object. The members of this struct are PRIVATE for the
+   arena module - DO NOT access from outside the arena module
+*/
+typedef struct _arenaStruct_ {
+  ArenaBlock *blocks; //!< list of blocks, most recent first
+  char *cur; //!< next free byte in the current block
+  char *end; //!< end of the current block
+  size_t blockSize; //!< size of a regular block
+  size_t bytes; //!< number of bytes handed out
+}*Arena;
+
+extern Arena arena_create (size_t blockSize);
+extern void arena_destroy_func (Arena this1); /* do not use this function */
+
+/**
+   Destroy the Arena and release all memory allocated from it;
+   do not call arena_destroy_func but only this macro
+*/
+#define arena_destroy(this1) (arena_destroy_func(this1),this1=NULL)
+
+extern void *arena_alloc (Arena this1,size_t n);
+extern void *arena_calloc (Arena this1,size_t nelem,size_t elsize);
+extern char *arena_strdup (Arena this1,char *s);
+extern char *arena_strndup (Arena this1,char *s,int n);
+extern void arena_clear (Arena this1);
+extern size_t arena_bytesGet (Arena this1);
+
+/* ------------ Arrays, Stringas and Textas living in an Arena ------------ */
+extern Array uArrayCreateIn (Arena arena,int n,int size); // do not use
+
+/**
+   Create an Array whose memory belongs to 'arena'.<br>
+   Such an Array is used like any other Array, but arrayDestroy() does
+   not free anything: the memory is released by arena_destroy().
+   When it grows, the old elements stay in the arena until then.
+   @param[in] arena - the Arena
+   @param[in] n - number of initial elements
+   @param[in] type - type of elements
+*/
+#define arrayCreateIn(arena,n,type) uArrayCreateIn(arena,n,sizeof(type))
+
+extern Stringa stringCreateIn (Arena arena,int initialSize);
+
+/**
+   Creates a Texta in 'arena' for initially 'initialSize' elements.
+   Add strings with textAddIn() only.
+*/
+#define textCreateIn(arena,initialSize) arrayCreateIn(arena,initialSize,char*)
+
+/**
+   Adds a copy of 's', allocated in 'arena', to Texta 't' created by
+   textCreateIn(); the counterpart of textAdd()
+*/
+#define textAddIn(arena,t,s) (array((t),arrayMax(t),char*)=arena_strdup((arena),(s)))
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
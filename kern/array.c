@@ -23,8 +23,14 @@
 /** @file array.c
     @brief Module for handling dynamic arrays.
 */
+#include "plabla.h"
 #include <string.h>
 #include <stdlib.h>
+#include <stdint.h>
+#ifdef PLABLA_HAVE_PTHREAD
+#include <pthread.h>
+#include PLABLA_INCLUDE_IO_UNISTD
+#endif
 #include "log.h"
 #include "array.h"
 
@@ -57,6 +63,8 @@ Array uArrayCreate (int n,int size) {
   new1->dim = n;
   new1->max = 0;
   new1->size = size;
+  new1->arena = NULL;
+  new1->arenaAlloc = NULL;
   nArrays++;
   return new1;
 }
@@ -82,12 +90,16 @@ static void arrayExtend (Array a,int n) {
   oldsize = (long int)a->size*(long int)a->max;
   if (newsize <= oldsize)
     die ("arrayExtend: oldsize %d, newsize %d",oldsize,newsize);
-  new1 = (char *)malloc (newsize);
+  if (a->arena != NULL) // the old memory is released with the arena
+    new1 = (char *)a->arenaAlloc (a->arena,newsize);
+  else
+    new1 = (char *)malloc (newsize);
   if (new1 == NULL)
     die (mallocErrorMsg);
   memcpy (new1,a->base,oldsize);
   memset (new1+oldsize,0,newsize-oldsize);
-  free (a->base);
+  if (a->arena == NULL)
+    free (a->base);
   a->base = new1;
 }
 
@@ -99,7 +111,7 @@ void uArrayDestroy (Array a) {
      NOTE: Do not call this function in any program.
            Use the macro arrayDestroy() instead
   */
-  if (a == NULL)
+  if (a == NULL || a->arena != NULL) // memory of an arena is freed with it
     return;
   free (a->base);
   free (a);
@@ -339,6 +351,291 @@ void arraySort (Array a,int (*order)(void*,void*)) {
     qsort (v,n,s,(int (*)(const void *,const void *))order);
 }
 
+/* ---------------- multithreaded sorting and uniq ---------------- */
+
+/// Arrays with fewer elements are sorted and uniq'ed serially
+#define ARRAY_PARALLEL_MIN 50000
+
+/// One piece of work of arraySortParallel() or arrayUniqParallel()
+typedef struct {
+  Array a; //!< the Array worked on
+  int (*order)(void*,void*); //!< the order function
+  char *src; //!< merge: elements to merge
+  char *dst; //!< merge: where the merged elements go
+  int lo; //!< first element of the range
+  int mid; //!< merge: first element of the second run
+  int hi; //!< one past the last element of the range
+  int kept; //!< uniq: number of elements kept at lo
+  Array dups; //!< uniq: duplicates found, NULL if not wanted
+}ArrayJob;
+
+static int arrayThreadCount (int nThreads,int n) {
+  /**
+     @param[in] nThreads - threads requested; <= 0 means one per processor
+     @param[in] n - number of elements
+     @return number of threads to work on n elements with;
+             1 means work serially
+  */
+#ifdef PLABLA_HAVE_PTHREAD
+  if (nThreads <= 0) {
+#ifdef _SC_NPROCESSORS_ONLN
+    nThreads = (int)sysconf (_SC_NPROCESSORS_ONLN);
+#else
+    nThreads = 1;
+#endif
+  }
+  if (n < ARRAY_PARALLEL_MIN)
+    return 1;
+  if (nThreads > n / (ARRAY_PARALLEL_MIN / 4))
+    nThreads = n / (ARRAY_PARALLEL_MIN / 4);
+  return nThreads > 1 ? nThreads : 1;
+#else
+  return 1;
+#endif
+}
+
+static void arrayRunJobs (ArrayJob *jobs,int nJobs,void *(*fn)(void *)) {
+  /**
+     Run fn() on each of the jobs, each in its own thread;
+     the last job runs in the calling thread
+  */
+#ifdef PLABLA_HAVE_PTHREAD
+  pthread_t *tids = (pthread_t *)malloc (nJobs * sizeof (pthread_t));
+  char *started = (char *)calloc (nJobs,1);
+  int i;
+
+  if (tids == NULL || started == NULL)
+    die (mallocErrorMsg);
+  for (i=0;i<nJobs-1;i++)
+    started[i] = pthread_create (&tids[i],NULL,fn,&jobs[i]) == 0;
+  fn (&jobs[nJobs-1]);
+  for (i=0;i<nJobs-1;i++)
+    if (started[i])
+      pthread_join (tids[i],NULL);
+    else
+      fn (&jobs[i]);
+  free (started);
+  free (tids);
+#else
+  int i;
+
+  for (i=0;i<nJobs;i++)
+    fn (&jobs[i]);
+#endif
+}
+
+static void *sortJob (void *arg) {
+  /**
+     Sort the range of one job in place
+  */
+  ArrayJob *job = (ArrayJob *)arg;
+
+  qsort (job->a->base + (size_t)job->lo * job->a->size,job->hi - job->lo,
+         job->a->size,(int (*)(const void *,const void *))job->order);
+  return NULL;
+}
+
+static void *mergeJob (void *arg) {
+  /**
+     Merge the sorted runs [lo,mid) and [mid,hi) of src into dst;
+     of equal elements, those of the first run come first
+  */
+  ArrayJob *job = (ArrayJob *)arg;
+  size_t s = job->a->size;
+  char *l = job->src + job->lo * s;
+  char *lEnd = job->src + job->mid * s;
+  char *r = lEnd;
+  char *rEnd = job->src + job->hi * s;
+  char *d = job->dst + job->lo * s;
+
+  while (l < lEnd && r < rEnd) {
+    if (job->order (r,l) < 0) {
+      memcpy (d,r,s);
+      r += s;
+    }
+    else {
+      memcpy (d,l,s);
+      l += s;
+    }
+    d += s;
+  }
+  if (l < lEnd)
+    memcpy (d,l,lEnd - l);
+  if (r < rEnd)
+    memcpy (d,r,rEnd - r);
+  return NULL;
+}
+
+void arraySortParallel (Array a,int (*order)(void*,void*),int nThreads) {
+  /**
+     Sorting an array using several threads: pieces of the Array are
+     sorted in parallel, then merged pairwise, also in parallel.
+     Small Arrays are sorted by arraySort().<br>
+     Note: order() is called from several threads at the same time;
+     it must not modify shared state
+     @param[in] a - the Array
+     @param[in] order - the order function, as for arraySort()
+     @param[in] nThreads - number of threads; <= 0 means one per processor
+  */
+  int n = a->max;
+  int nRuns = arrayThreadCount (nThreads,n);
+  ArrayJob *jobs;
+  int *bnd;
+  char *tmp,*src,*dst;
+  int i,k;
+
+  if (nRuns < 2) {
+    arraySort (a,order);
+    return;
+  }
+  jobs = (ArrayJob *)calloc (nRuns,sizeof (ArrayJob));
+  bnd = (int *)malloc ((nRuns + 1) * sizeof (int));
+  tmp = (char *)malloc ((size_t)n * a->size);
+  if (jobs == NULL || bnd == NULL || tmp == NULL)
+    die (mallocErrorMsg);
+  for (i=0;i<=nRuns;i++)
+    bnd[i] = (int)((long int)n * i / nRuns);
+  for (i=0;i<nRuns;i++) {
+    jobs[i].a = a;
+    jobs[i].order = order;
+    jobs[i].lo = bnd[i];
+    jobs[i].hi = bnd[i+1];
+  }
+  arrayRunJobs (jobs,nRuns,sortJob);
+  src = a->base;
+  dst = tmp;
+  while (nRuns > 1) {
+    for (i=0,k=0;i+1<nRuns;i+=2,k++) {
+      jobs[k].src = src;
+      jobs[k].dst = dst;
+      jobs[k].lo = bnd[i];
+      jobs[k].mid = bnd[i+1];
+      jobs[k].hi = bnd[i+2];
+    }
+    if (i < nRuns) // odd run out: copy over unchanged
+      memcpy (dst + (size_t)bnd[i] * a->size,src + (size_t)bnd[i] * a->size,
+              (size_t)(bnd[i+1] - bnd[i]) * a->size);
+    arrayRunJobs (jobs,k,mergeJob);
+    for (i=0;2*i<nRuns;i++)
+      bnd[i] = bnd[2*i];
+    bnd[i] = n;
+    nRuns = i;
+    tmp = dst; // the merged runs are the input of the next round
+    dst = src;
+    src = tmp;
+  }
+  if (src == a->base)
+    free (dst);
+  else if (a->arena != NULL) { // result is in the scratch buffer
+    memcpy (a->base,src,(size_t)n * a->size);
+    free (src);
+  }
+  else { // keep the scratch buffer as the new base
+    free (a->base);
+    a->base = src;
+    a->dim = n;
+  }
+  free (bnd);
+  free (jobs);
+}
+
+static void *uniqJob (void *arg) {
+  /**
+     Remove duplicates from the range of one job in place like
+     arrayUniq(), except for the first element of the range which
+     is always kept
+  */
+  ArrayJob *job = (ArrayJob *)arg;
+  Array a = job->a;
+  size_t s = a->size;
+  char *to = a->base + (size_t)job->lo * s;
+  char *from;
+  int i;
+
+  for (i=job->lo+1;i<job->hi;i++) {
+    from = a->base + (size_t)i * s;
+    if (job->order (to,from) != 0) {
+      to += s;
+      if (to != from)
+        memcpy (to,from,s);
+    }
+    else if (job->dups != NULL)
+      memcpy (uArray (job->dups,arrayMax (job->dups)),from,s);
+  }
+  job->kept = (int)((to - (a->base + (size_t)job->lo * s)) / s) + 1;
+  return NULL;
+}
+
+void arrayUniqParallel (Array a,Array b,int (*order)(void*,void*),
+                        int nThreads) {
+  /**
+     Make a sorted Array unique using several threads; same result as
+     arrayUniq(), including the order of the duplicates in b.
+     Small Arrays are handled by arrayUniq().<br>
+     Note: order() is called from several threads at the same time;
+     it must not modify shared state
+     @param[in] a - Array sorted by the order function
+     @param[in] b - Array of same type as a, NULL ok
+     @param[in] order - the order function
+     @param[in] nThreads - number of threads; <= 0 means one per processor
+     @param[out] a - the Array without duplicates
+     @param[out] b - if not NULL: duplicates appended
+  */
+  int n,nJobs,i,max;
+  size_t s;
+  ArrayJob *jobs;
+  char *last;
+
+  if (a == NULL || a->size == 0 || (b && a->size != b->size))
+    die ("arrayUniqParallel: bad input");
+  n = arrayMax (a);
+  nJobs = arrayThreadCount (nThreads,n);
+  if (nJobs < 2) {
+    arrayUniq (a,b,order);
+    return;
+  }
+  s = a->size;
+  jobs = (ArrayJob *)calloc (nJobs,sizeof (ArrayJob));
+  if (jobs == NULL)
+    die (mallocErrorMsg);
+  for (i=0;i<nJobs;i++) {
+    jobs[i].a = a;
+    jobs[i].order = order;
+    jobs[i].lo = (int)((long int)n * i / nJobs);
+    jobs[i].hi = (int)((long int)n * (i+1) / nJobs);
+    jobs[i].dups = b ? uArrayCreate ((jobs[i].hi - jobs[i].lo) / 16,s) : NULL;
+  }
+  arrayRunJobs (jobs,nJobs,uniqJob);
+  // join the pieces; the first element of a piece may equal the last one kept
+  max = jobs[0].kept;
+  for (i=0;i<nJobs;i++) {
+    if (i > 0) {
+      last = a->base + (size_t)(max - 1) * s;
+      if (order (last,a->base + (size_t)jobs[i].lo * s) == 0) {
+        if (b != NULL)
+          memcpy (uArray (b,arrayMax (b)),a->base + (size_t)jobs[i].lo * s,s);
+        jobs[i].lo++;
+        jobs[i].kept--;
+      }
+    }
+    if (b != NULL) {
+      if (arrayMax (jobs[i].dups) > 0) {
+        uArray (b,arrayMax (b) + arrayMax (jobs[i].dups) - 1);
+        memcpy (b->base + (size_t)(arrayMax (b) - arrayMax (jobs[i].dups)) * s,
+                jobs[i].dups->base,(size_t)arrayMax (jobs[i].dups) * s);
+      }
+      uArrayDestroy (jobs[i].dups);
+    }
+    if (i == 0)
+      continue;
+    memmove (a->base + (size_t)max * s,a->base + (size_t)jobs[i].lo * s,
+             (size_t)jobs[i].kept * s);
+    max += jobs[i].kept;
+  }
+  arrayMax (a) = max;
+  free (jobs);
+}
+
 int arrayFind (Array a,void *s,int *ip,int (* order)(void*, void*)) {
   /**
      Finds entry s in Array a sorted in ascending order of order()
@@ -690,6 +987,275 @@ int arrayStrcmp2 (char **s1,char **s2) {
   return strcmp2 (*s1,*s2);
 }
 
+/* ---------------- radix sort on primitive keys ----------------
+   LSD radix sort with 8-bit digits. The histograms of all digits are
+   collected in one pass over the keys; a digit in which all keys agree
+   needs no pass. Signed and floating point keys are first mapped to
+   unsigned integers of the same order. */
+
+static void radixSort32 (uint32_t *key,int n) {
+  /**
+     Sort 'n' unsigned 32-bit keys ascending
+  */
+  int cnt[4][256];
+  uint32_t *tmp,*src,*dst,*t;
+  int i,d,sum,c;
+
+  memset (cnt,0,sizeof (cnt));
+  for (i=0;i<n;i++)
+    for (d=0;d<4;d++)
+      cnt[d][(key[i] >> (8*d)) & 0xff]++;
+  tmp = (uint32_t *)malloc ((size_t)n * sizeof (uint32_t));
+  if (tmp == NULL)
+    die (mallocErrorMsg);
+  src = key;
+  dst = tmp;
+  for (d=0;d<4;d++) {
+    if (cnt[d][(key[0] >> (8*d)) & 0xff] == n)
+      continue;
+    for (sum=0,i=0;i<256;i++) {
+      c = cnt[d][i];
+      cnt[d][i] = sum;
+      sum += c;
+    }
+    for (i=0;i<n;i++)
+      dst[cnt[d][(src[i] >> (8*d)) & 0xff]++] = src[i];
+    t = src;
+    src = dst;
+    dst = t;
+  }
+  if (src != key)
+    memcpy (key,src,(size_t)n * sizeof (uint32_t));
+  free (tmp);
+}
+
+static void radixSort64 (uint64_t *key,int *idx,int n,
+                         uint64_t *tmpBuf,int *itmpBuf) {
+  /**
+     Sort 'n' unsigned 64-bit keys ascending; the sort is stable
+     @param[in] key - the keys
+     @param[in] idx - NULL or a payload moved along with the keys
+     @param[in] n - number of keys
+     @param[in] tmpBuf, itmpBuf - NULL or work space for n keys and
+                                  n payloads
+  */
+  int cnt[8][256];
+  uint64_t *tmp,*src,*dst,*t;
+  int *itmp = NULL,*isrc = idx,*idst = NULL,*it;
+  int i,d,sum,c,b;
+
+  memset (cnt,0,sizeof (cnt));
+  tmp = tmpBuf != NULL ? tmpBuf : (uint64_t *)malloc ((size_t)n * sizeof (uint64_t));
+  if (idx != NULL)
+    itmp = itmpBuf != NULL ? itmpBuf : (int *)malloc ((size_t)n * sizeof (int));
+  if (tmp == NULL || (idx != NULL && itmp == NULL))
+    die (mallocErrorMsg);
+  for (i=0;i<n;i++)
+    for (d=0;d<8;d++)
+      cnt[d][(key[i] >> (8*d)) & 0xff]++;
+  src = key;
+  dst = tmp;
+  idst = itmp;
+  for (d=0;d<8;d++) {
+    if (cnt[d][(key[0] >> (8*d)) & 0xff] == n)
+      continue;
+    for (sum=0,i=0;i<256;i++) {
+      c = cnt[d][i];
+      cnt[d][i] = sum;
+      sum += c;
+    }
+    for (i=0;i<n;i++) {
+      b = cnt[d][(src[i] >> (8*d)) & 0xff]++;
+      dst[b] = src[i];
+      if (idx != NULL)
+        idst[b] = isrc[i];
+    }
+    t = src;
+    src = dst;
+    dst = t;
+    it = isrc;
+    isrc = idst;
+    idst = it;
+  }
+  if (src != key) {
+    memcpy (key,src,(size_t)n * sizeof (uint64_t));
+    if (idx != NULL)
+      memcpy (idx,isrc,(size_t)n * sizeof (int));
+  }
+  if (itmpBuf == NULL)
+    free (itmp);
+  if (tmpBuf == NULL)
+    free (tmp);
+}
+
+static uint64_t doubleKey (uint64_t u) {
+  /**
+     Map the bits of a double to an unsigned integer with the same order:
+     negative numbers have all bits flipped, others only the sign bit
+  */
+  return (u & ((uint64_t)1 << 63)) ? ~u : u | ((uint64_t)1 << 63);
+}
+
+static uint64_t keyDouble (uint64_t u) {
+  /**
+     Inverse of doubleKey()
+  */
+  return (u & ((uint64_t)1 << 63)) ? u & ~((uint64_t)1 << 63) : ~u;
+}
+
+void arraySortInts (int *x,int n) {
+  /**
+     Sort a vector of int ascending, like qsort() with arrayIntcmp()
+     but with a radix sort which does not call a comparison function
+     @param[in] x - the numbers
+     @param[in] n - how many
+     @param[out] x - sorted
+  */
+  uint32_t *u = (uint32_t *)x;
+  int i;
+
+  if (n < 2)
+    return;
+  for (i=0;i<n;i++)
+    u[i] ^= (uint32_t)1 << 31;
+  radixSort32 (u,n);
+  for (i=0;i<n;i++)
+    u[i] ^= (uint32_t)1 << 31;
+}
+
+void arraySortDoubles (double *x,int n) {
+  /**
+     Sort a vector of double ascending, like qsort() with arrayDoublecmp()
+     but with a radix sort which does not call a comparison function.<br>
+     Note: -0.0 is placed before 0.0; NaNs go to the end
+     (or to the start if their sign bit is set)
+     @param[in] x - the numbers
+     @param[in] n - how many
+     @param[out] x - sorted
+  */
+  uint64_t *key;
+  uint64_t u;
+  int i;
+
+  if (n < 2)
+    return;
+  // the keys get their own memory: accessing the doubles through a
+  // uint64_t pointer would break strict aliasing
+  if ((key = (uint64_t *)malloc ((size_t)n * 2 * sizeof (uint64_t))) == NULL)
+    die (mallocErrorMsg);
+  for (i=0;i<n;i++) {
+    memcpy (&u,&x[i],sizeof (u));
+    key[i] = doubleKey (u);
+  }
+  radixSort64 (key,NULL,n,key + n,NULL);
+  for (i=0;i<n;i++) {
+    u = keyDouble (key[i]);
+    memcpy (&x[i],&u,sizeof (u));
+  }
+  free (key);
+}
+
+void arraySortInt (Array a) {
+  /**
+     Sort an Array of int ascending; same result as
+     arraySort (a,(ARRAYORDERF)arrayIntcmp), but faster
+     @param[in] a - the Array
+  */
+  if (a->size != sizeof (int))
+    die ("arraySortInt: not an Array of int");
+  arraySortInts ((int *)a->base,a->max);
+}
+
+void arraySortDouble (Array a) {
+  /**
+     Sort an Array of double ascending; same result as
+     arraySort (a,(ARRAYORDERF)arrayDoublecmp), but faster;
+     see arraySortDoubles() for -0.0 and NaN
+     @param[in] a - the Array
+  */
+  if (a->size != sizeof (double))
+    die ("arraySortDouble: not an Array of double");
+  arraySortDoubles ((double *)a->base,a->max);
+}
+
+void arraySortByDoubleField (Array a,int offset) {
+  /**
+     Sort an Array of structs ascending by a member of type double;
+     the sort is stable, i.e. elements with equal keys keep their order.<br>
+     Example: arraySortByDoubleField (a,offsetof (IndexedValue,value))
+     @param[in] a - the Array
+     @param[in] offset - offset of the double in each element in bytes,
+                         typically from offsetof()
+  */
+  int n = a->max;
+  int s = a->size;
+  uint64_t *key;
+  int *idx;
+  char *sorted;
+  uint64_t x;
+  int i;
+
+  if (offset < 0 || offset + (int)sizeof (double) > s)
+    die ("arraySortByDoubleField: offset %d outside element of %d bytes",
+         offset,s);
+  if (n < 2)
+    return;
+  key = (uint64_t *)malloc ((size_t)n * sizeof (uint64_t));
+  idx = (int *)malloc ((size_t)n * sizeof (int));
+  sorted = (char *)malloc ((size_t)n * s);
+  if (key == NULL || idx == NULL || sorted == NULL)
+    die (mallocErrorMsg);
+  for (i=0;i<n;i++) {
+    memcpy (&x,a->base + (size_t)i * s + offset,sizeof (x));
+    key[i] = doubleKey (x);
+    idx[i] = i;
+  }
+  radixSort64 (key,idx,n,NULL,NULL);
+  for (i=0;i<n;i++)
+    memcpy (sorted + (size_t)i * s,a->base + (size_t)idx[i] * s,s);
+  memcpy (a->base,sorted,(size_t)n * s);
+  free (sorted);
+  free (idx);
+  free (key);
+}
+
+void arrayOrderDoubles (double *x,int n,int *order,Array work) {
+  /**
+     Find the order of a vector of double without changing it: afterwards
+     x[order[0]] <= x[order[1]] <= ...; equal values keep their order
+     (radix sort, see arraySortDoubles() for -0.0 and NaN)
+     @param[in] x - the numbers
+     @param[in] n - how many
+     @param[in] work - NULL or an Array reused as work space, to avoid
+                       allocations when called many times
+     @param[out] order - n indices into x
+  */
+  uint64_t *key,*tmp;
+  uint64_t u;
+  size_t bytes = (size_t)n * (2 * sizeof (uint64_t) + sizeof (int));
+  int i;
+
+  for (i=0;i<n;i++)
+    order[i] = i;
+  if (n < 2)
+    return;
+  if (work != NULL) {
+    arraySetMax (work,0);
+    uArray (work,(int)((bytes + work->size - 1) / work->size)); // make room
+    key = (uint64_t *)work->base;
+  }
+  else if ((key = (uint64_t *)malloc (bytes)) == NULL)
+    die (mallocErrorMsg);
+  tmp = key + n;
+  for (i=0;i<n;i++) {
+    memcpy (&u,&x[i],sizeof (u));
+    key[i] = doubleKey (u);
+  }
+  radixSort64 (key,order,n,tmp,(int *)(tmp + n));
+  if (work == NULL)
+    free (key);
+}
+
 int arrayIntcmp (int *ip1,int *ip2) {
   /**
      Order function for Array of integers
@@ -38,12 +38,16 @@ extern "C" {
 
 /* #define ARRAY_CHECK */
 
+#include <stddef.h>
+
 //! the Array structure
 typedef struct ArrayStruct {
   char* base; //!< char* since need to do pointer arithmetic in bytes
   int   dim;  //!< length of alloc'ed space, counted in elements
   int   size; //!< size of one array element
   int   max;  //!< number of elements in array
+  void *arena; //!< Arena owning the memory (see arena.h), NULL if malloc'ed
+  void *(*arenaAlloc)(void *arena,size_t n); //!< allocates from 'arena'
 }*Array;
 
 /* NB we need the full definition for arru() for macros to work
@@ -161,6 +165,16 @@ extern void arrayMove (Array from,int start,int end,Array to);
 extern void arrayByteUniq (Array a);
 extern void arrayUniq (Array a,Array b,int (*order)(void*,void*));
 extern void arraySort (Array a,int (*order)(void*,void*));
+extern void arraySortInt (Array a);
+extern void arraySortDouble (Array a);
+extern void arraySortByDoubleField (Array a,int offset);
+extern void arraySortParallel (Array a,int (*order)(void*,void*),
+                               int nThreads);
+extern void arrayUniqParallel (Array a,Array b,int (*order)(void*,void*),
+                               int nThreads);
+extern void arraySortInts (int *x,int n);
+extern void arraySortDoubles (double *x,int n);
+extern void arrayOrderDoubles (double *x,int n,int *order,Array work);
 extern int arrayFind (Array a,void *s,int *ip,int (*order)(void*,void*));
 extern int arrayFindInsert (Array a,void *s,int *ip,int (*order)(void*,void*));
 
@@ -17,18 +17,78 @@
 /** @file avlTree.c
     @brief Module dealing with AVL balanced binary tree functions.
     Module prefix avl_
+    <br>
+    The nodes of a tree are allocated from blocks owned by the tree
+    (starting small and doubling up to AVL_MAXBLOCK nodes); deleted nodes
+    are kept for reuse and all blocks are freed by avl_treeDestroy().
 */
 #include "log.h"
 #include "hlrmisc.h"
 #include "avlTree.h"
 
+/// number of nodes in the first block of a tree
+#define AVL_MINBLOCK 8
+
+/// maximal number of nodes in one block
+#define AVL_MAXBLOCK 4096
+
+/// log2 of the maximal number of nodes in one block of avl_treeBuildSorted()
+#define AVL_BUILDSHIFT 20
+
+/// a block of nodes
+typedef struct _AvlBlockStruct_ {
+  struct _AvlBlockStruct_ *next; //!< block allocated before this one
+  int numNodes; //!< number of nodes in this block
+  int numUsed; //!< number of nodes handed out from this block
+  struct _AvlNodeStruct_ nodes[1]; //!< the nodes
+}AvlBlock;
+
 static void avl_nodeCreate (AvlNode node) {
+  node->value = NULL;
   node->leftNode = NULL;
   node->rightNode = NULL;
   node->parentNode = NULL;
   node->height = 1;
 }
 
+static AvlBlock *avl_blockAdd (AvlTree this1,int numNodes) {
+  /**
+     Adds a block for numNodes nodes to the tree
+  */
+  AvlBlock *block = (AvlBlock *)hlr_malloc (sizeof (AvlBlock) +
+                                            (numNodes - 1) * sizeof (struct _AvlNodeStruct_));
+  block->next = (AvlBlock *)this1->nodeBlocks;
+  block->numNodes = numNodes;
+  block->numUsed = 0;
+  this1->nodeBlocks = block;
+  return block;
+}
+
+static AvlNode avl_nodeAlloc (AvlTree this1) {
+  /**
+     @return a node from the pool of the tree; its members are not set
+  */
+  AvlBlock *block = (AvlBlock *)this1->nodeBlocks;
+  AvlNode node;
+
+  if ((node = this1->freeNodes) != NULL) {
+    this1->freeNodes = node->rightNode;
+    return node;
+  }
+  if (block == NULL || block->numUsed == block->numNodes)
+    block = avl_blockAdd (this1,block == NULL ? AVL_MINBLOCK :
+                          MIN (2 * block->numNodes,AVL_MAXBLOCK));
+  return &block->nodes[block->numUsed++];
+}
+
+static void avl_nodeFree (AvlTree this1,AvlNode node) {
+  /**
+     Returns a node to the pool of the tree
+  */
+  node->rightNode = this1->freeNodes;
+  this1->freeNodes = node;
+}
+
 AvlTree avl_treeCreate (int (*cmpFunction)(void *,void *),
                         void (*cleanFunction)(void *)) {
   /**
@@ -47,26 +107,19 @@ AvlTree avl_treeCreate (int (*cmpFunction)(void *,void *),
   this1->compareFunction = cmpFunction;
   this1->cleanFunction = cleanFunction;
   this1->balFlag = 0;
+  this1->numNodes = 0;
+  this1->nodeBlocks = NULL;
+  this1->freeNodes = NULL;
   return this1;
 }
 
 static void avl_nodeDestroy (AvlNode node,void (*cleanFunc)(void *)) {
+  // cleans the values of the subtree; the nodes are freed with their blocks
   if (node == NULL)
     return;
   avl_nodeDestroy (node->leftNode,cleanFunc);
   avl_nodeDestroy (node->rightNode,cleanFunc);
-  if (node->parentNode != NULL) {
-    if (node->parentNode->leftNode == node)
-      node->parentNode->leftNode = NULL;
-    if (node->parentNode->rightNode == node)
-      node->parentNode->rightNode = NULL;
-  }
   cleanFunc (node->value);
-  hlr_free (node);
-}
-
-static void avl_defaultCleanFunc (void *value) {
-  return;
 }
 void avl_treeDestroyFunc (AvlTree this1) {
   /**
@@ -80,8 +133,14 @@ void avl_treeDestroyFunc (AvlTree this1) {
            should be used instead from outside the package.
      @param[in] this1 - AvlTree that should be destroyed
   */
+  AvlBlock *block;
+
   avl_nodeDestroy (this1->rootTree->leftNode,this1->cleanFunction);
-  avl_nodeDestroy (this1->rootTree,avl_defaultCleanFunc);
+  while ((block = (AvlBlock *)this1->nodeBlocks) != NULL) {
+    this1->nodeBlocks = block->next;
+    hlr_free (block);
+  }
+  hlr_free (this1->rootTree);
   hlr_free (this1);
 }
 
@@ -232,7 +291,7 @@ static void avl_nodeReplace (AvlNode nodeOld,AvlNode nodeNew) {
 
 static AvlNode avl_nodeRestructure (AvlNode unBalNode,
                                     int *balFlag) {
-  AvlNode arrNodes[7];
+  AvlNode arrNodes[7] = {NULL}; // all set below, silences -Wmaybe-uninitialized
   int flagHeavy = avl_nodeChkHeavyDir (unBalNode);
   if (abs (flagHeavy) < 2)
     return unBalNode;
@@ -365,13 +424,13 @@ int avl_treeDelete (AvlTree this1,void *valueToDelete) {
      @param[in] valueToDelete - a pointer to value to delete
      @return 0 if not found, else 1 if sucessfully deleted
   */
-  AvlNode newNode = (AvlNode)hlr_malloc (sizeof (struct _AvlNodeStruct_));
-  avl_nodeCreate (newNode);
-  newNode->value = valueToDelete;
-  AvlNode nodeDeleted = avl_nodeDelete (this1,this1->rootTree->leftNode,newNode);
-  hlr_free (newNode);
+  struct _AvlNodeStruct_ tmpNode;
+  avl_nodeCreate (&tmpNode);
+  tmpNode.value = valueToDelete;
+  AvlNode nodeDeleted = avl_nodeDelete (this1,this1->rootTree->leftNode,&tmpNode);
   if (nodeDeleted != NULL) {
-    avl_nodeDestroy (nodeDeleted,this1->cleanFunction);
+    this1->cleanFunction (nodeDeleted->value);
+    avl_nodeFree (this1,nodeDeleted);
     this1->numNodes--;
     return 1;
   }
@@ -430,7 +489,7 @@ int avl_treeInsert (AvlTree this1,void *valueToInsert,
                              valueToInsert is already found on the tree.
      @return 0 if found, else 1 if sucessfully inserted
   */
-  AvlNode newNode = (AvlNode)hlr_malloc (sizeof (struct _AvlNodeStruct_));
+  AvlNode newNode = avl_nodeAlloc (this1);
   avl_nodeCreate (newNode);
   newNode->value = valueToInsert;
   if (avl_treeIsEmpty (this1)) {
@@ -442,11 +501,68 @@ int avl_treeInsert (AvlTree this1,void *valueToInsert,
                                      this1->compareFunction,
                                      modifyFunc,&this1->balFlag);
   if (!flagInserted)
-    hlr_free (newNode);
+    avl_nodeFree (this1,newNode);
   this1->numNodes += flagInserted;
   return flagInserted;
 }
 
+static AvlNode avl_nodeBuild (AvlNode *blockNodes,void **values,
+                              long lo,long hi) {
+  // builds a balanced subtree from values[lo..hi-1] using nodes lo..hi-1,
+  // node i being number i % 2^AVL_BUILDSHIFT of block i / 2^AVL_BUILDSHIFT
+  if (lo >= hi)
+    return NULL;
+  long mid = lo + (hi - lo) / 2;
+  AvlNode node = blockNodes[mid >> AVL_BUILDSHIFT] +
+    (mid & ((1L << AVL_BUILDSHIFT) - 1));
+  avl_nodeCreate (node);
+  node->value = values[mid];
+  avl_nodeAssignChildren (node,avl_nodeBuild (blockNodes,values,lo,mid),
+                          avl_nodeBuild (blockNodes,values,mid+1,hi));
+  return node;
+}
+
+void avl_treeBuildSorted (AvlTree this1,void **values,long n) {
+  /**
+     Fills an empty AvlTree with values which are already sorted, in O(n)
+     time and with one allocation per 2^AVL_BUILDSHIFT (about a million)
+     values; the tree is perfectly balanced.
+     Values are inserted as if by avl_treeInsert() one by one, except
+     that they must be strictly increasing according to the compare
+     function of the tree.<br>
+     Precondition: the tree is empty
+     @param[in] this1 - an AvlTree
+     @param[in] values - n values sorted in increasing order without
+                         duplicates
+     @param[in] n - number of values
+  */
+  AvlBlock *block;
+  AvlNode *blockNodes;
+  AvlNode root;
+  long i,numBlocks;
+
+  if (!avl_treeIsEmpty (this1))
+    die ("avl_treeBuildSorted: tree is not empty");
+  if (n <= 0)
+    return;
+  for (i=1;i<n;i++)
+    if (this1->compareFunction (values[i-1],values[i]) >= 0)
+      die ("avl_treeBuildSorted: values %ld and %ld not in increasing order",
+           i-1,i);
+  numBlocks = ((n - 1) >> AVL_BUILDSHIFT) + 1;
+  blockNodes = (AvlNode *)hlr_malloc (numBlocks * sizeof (AvlNode));
+  for (i=0;i<numBlocks;i++) {
+    block = avl_blockAdd (this1,(int)MIN (n - (i << AVL_BUILDSHIFT),
+                                          1L << AVL_BUILDSHIFT));
+    block->numUsed = block->numNodes;
+    blockNodes[i] = block->nodes;
+  }
+  root = avl_nodeBuild (blockNodes,values,0,n);
+  hlr_free (blockNodes);
+  avl_nodeAssignChildren (this1->rootTree,root,root);
+  this1->numNodes = n;
+}
+
 static AvlNode avl_nodeFind (AvlNode rootNode,AvlNode nodeToFind,
                              int (*cmpFunction)(void *,void *)) {
   // returns NULL if not found
@@ -479,13 +595,13 @@ int avl_treeFind (AvlTree this1,void *valueToFind,void **valueFound) {
   */
   if (avl_treeIsEmpty (this1))
     return 0;
-  AvlNode tmpNode = (AvlNode)hlr_malloc (sizeof (struct _AvlNodeStruct_));
+  struct _AvlNodeStruct_ tmpNodeSpace;
+  AvlNode tmpNode = &tmpNodeSpace;
   avl_nodeCreate (tmpNode);
   tmpNode->value = valueToFind;
   AvlNode foundNode = NULL;
   foundNode = avl_nodeFind (this1->rootTree->leftNode,tmpNode,
                             this1->compareFunction);
-  hlr_free (tmpNode);
   if (foundNode == NULL)
     return 0;
   *valueFound = foundNode->value;
@@ -586,7 +702,8 @@ void *avl_treeNextValue (AvlTree this1,void *currVal,int *foundFlag) {
   if (avl_treeIsEmpty (this1))
     return NULL;
   *foundFlag = 1;
-  AvlNode tmpNode = (AvlNode)hlr_malloc (sizeof (struct _AvlNodeStruct_));
+  struct _AvlNodeStruct_ tmpNodeSpace;
+  AvlNode tmpNode = &tmpNodeSpace;
   avl_nodeCreate (tmpNode);
   tmpNode->value = currVal;
   AvlNode currValNode = NULL;
@@ -594,7 +711,6 @@ void *avl_treeNextValue (AvlTree this1,void *currVal,int *foundFlag) {
   currValNode = avl_nodeFindElseNeighbor (this1->rootTree->leftNode,
                                           tmpNode,this1->compareFunction,
                                           &flagPrevNext);
-  hlr_free (tmpNode);
   if (flagPrevNext != 0)
     *foundFlag = 0;
   if (flagPrevNext == 1)
@@ -656,7 +772,8 @@ void *avl_treePrevValue (AvlTree this1,void *currVal,int *foundFlag) {
   if (avl_treeIsEmpty (this1))
     return NULL;
   *foundFlag = 1;
-  AvlNode tmpNode = (AvlNode)hlr_malloc (sizeof (struct _AvlNodeStruct_));
+  struct _AvlNodeStruct_ tmpNodeSpace;
+  AvlNode tmpNode = &tmpNodeSpace;
   avl_nodeCreate (tmpNode);
   tmpNode->value = currVal;
   AvlNode currValNode = NULL;
@@ -664,7 +781,6 @@ void *avl_treePrevValue (AvlTree this1,void *currVal,int *foundFlag) {
   currValNode = avl_nodeFindElseNeighbor (this1->rootTree->leftNode,
                                           tmpNode,this1->compareFunction,
                                           &flagPrevNext);
-  hlr_free (tmpNode);
   if (flagPrevNext != 0)
     *foundFlag = 0;
   if (flagPrevNext == -1)
@@ -46,6 +46,8 @@ typedef struct _AvlTreeStruct_ {
   void (*cleanFunction)(void *); //!< function to use to clean nodes
   int balFlag; //!< indicates whether the tree is balanced
   long numNodes; //!< keeps track of the current number of nodes
+  void *nodeBlocks; //!< blocks the nodes are allocated from
+  AvlNode freeNodes; //!< deleted nodes kept for reuse
 }*AvlTree;
 
 extern AvlTree avl_treeCreate (int (*cmpFunction)(void *,void *),
@@ -54,6 +56,7 @@ extern void avl_treeDestroyFunc (AvlTree this1);
 /// call this macro not the function avl_treeDestroyFunc()
 #define avl_treeDestroy(x) ((x) ? avl_treeDestroyFunc(x),x=NULL,1:0)
 extern int avl_treeIsEmpty (AvlTree this1);
+extern void avl_treeBuildSorted (AvlTree this1,void **values,long n);
 extern int avl_treeIsConsistent (AvlTree this1);
 extern int avl_treeDelete (AvlTree this1,void *valueToDelete);
 extern int avl_treeInsert (AvlTree this1,void *valueToInsert,
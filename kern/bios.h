@@ -14,12 +14,14 @@ extern "C" {
 #include <alphatrans.h>
 #include <arg.h>
 #include <array.h>
+#include <arena.h>
 #include <avlTree.h>
 #include <binalgparser.h>
 #include <biosdefs.h>
 #include <biosdefs_oracle.h>
 #include <biosdefs_postgres.h>
 #include <bitmap.h>
+#include <btree.h>
 #include <biurl.h>
 #include <blastdb.h>
 #include <blastparser.h>
@@ -39,12 +41,14 @@ extern "C" {
 #include <hmmparser.h>
 #include <htmlform.h>
 #include <html.h>
+#include <intern.h>
 #include <iwbiconf.h>
 #include <linestream.h>
 #include <lnk.h>
 #include <log.h>
 #include <matvec.h>
 #include <msfparser.h>
+#include <ohtable.h>
 #include <notifierconf.h>
 #include <notifier.h>
 #include <pagedesign.h>
@@ -64,6 +68,7 @@ extern "C" {
 #include <seqautil.h>
 #include <sequenceAlignment.h>
 #include <sequtil.h>
+#include <sstable.h>
 #include <statistics.h>
 #include <stringlist.h>
 #include <switch.h>
@@ -0,0 +1,651 @@
+/*****************************************************************************
+* (c) Copyright 2012-2013 F.Hoffmann-La Roche AG                             *
+* Contact: bioinfoc@bioinfoc.ch, Detlef.Wolf@Roche.com.                      *
+*                                                                            *
+* This file is part of BIOINFO-C. BIOINFO-C is free software: you can        *
+* redistribute it and/or modify it under the terms of the GNU Lesser         *
+* General Public License as published by the Free Software Foundation,       *
+* either version 3 of the License, or (at your option) any later version.    *
+*                                                                            *
+* BIOINFO-C is distributed in the hope that it will be useful, but           *
+* WITHOUT ANY WARRANTY; without even the implied warranty of                 *
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU          *
+* Lesser General Public License for more details. You should have            *
+* received a copy of the GNU Lesser General Public License along with        *
+* BIOINFO-C. If not, see <http://www.gnu.org/licenses/>.                     *
+*****************************************************************************/
+/** @file btree.c
+    @brief Module for ordered sets in B+-trees, an alternative to AvlTree
+    for large sets: many values per node and linked leaves make lookups
+    and ordered scans cache friendly.
+    Module prefix btree_
+    <br>
+    The values are kept in the leaves, up to BTREE_ORDER per leaf, and
+    the leaves are linked in both directions for iteration. An inner
+    node with n keys has n+1 children; key i is the smallest value in
+    child i+1. Keys are pointers to values in the tree, so deleting a
+    value replaces the key referring to it before the value is cleaned.
+    All nodes but the root hold at least BTREE_ORDER/2 values or keys.
+    <br>
+    Usage like AvlTree:<br>
+    BTree t = btree_treeCreate (myCompare,myClean);<br>
+    btree_treeInsert (t,value,NULL);<br>
+    it = btree_itCreate (t);<br>
+    while ((value = btree_itNextValue (it)) != NULL) ...<br>
+    btree_itDestroy (it);<br>
+    btree_treeDestroy (t);
+*/
+#include <string.h>
+#include <stddef.h>
+#include "log.h"
+#include "hlrmisc.h"
+#include "btree.h"
+
+/// maximal number of values in a leaf and of keys in an inner node
+#define BTREE_ORDER 64
+
+/// minimal number of values or keys in a node other than the root
+#define BTREE_MIN (BTREE_ORDER / 2)
+
+/// maximal height of a tree; enough for any number of values in memory
+#define BTREE_MAXHEIGHT 32
+
+/// a node of a BTree; leaves are allocated without the child array
+typedef struct _BtNodeStruct_ {
+  int isLeaf; //!< 1 for a leaf, 0 for an inner node
+  int n; //!< number of values (leaf) or keys (inner node)
+  void *keys[BTREE_ORDER + 1]; //!< values or keys; one spare before a split
+  struct _BtNodeStruct_ *prev; //!< leaves: the leaf before this one
+  struct _BtNodeStruct_ *next; //!< leaves: the leaf after this one
+  struct _BtNodeStruct_ *child[BTREE_ORDER + 2]; //!< inner nodes: n+1 children
+}*BtNode;
+
+static BtNode btree_nodeCreate (int isLeaf) {
+  BtNode node = (BtNode)hlr_malloc (isLeaf ?
+                                    offsetof (struct _BtNodeStruct_,child) :
+                                    sizeof (struct _BtNodeStruct_));
+  node->isLeaf = isLeaf;
+  node->n = 0;
+  node->prev = NULL;
+  node->next = NULL;
+  return node;
+}
+
+static void btree_nodeDestroy (BtNode node,void (*cleanFunc)(void *)) {
+  int i;
+
+  if (node->isLeaf) {
+    for (i=0;i<node->n;i++)
+      cleanFunc (node->keys[i]);
+  }
+  else
+    for (i=0;i<=node->n;i++)
+      btree_nodeDestroy (node->child[i],cleanFunc);
+  hlr_free (node);
+}
+
+static int btree_leafSearch (BTree this1,BtNode leaf,void *value,int *found) {
+  // returns the position of the first value not smaller than 'value'
+  int lo = 0,hi = leaf->n,mid;
+
+  while (lo < hi) {
+    mid = (lo + hi) / 2;
+    if (this1->compareFunction (value,leaf->keys[mid]) > 0)
+      lo = mid + 1;
+    else
+      hi = mid;
+  }
+  *found = lo < leaf->n && this1->compareFunction (value,leaf->keys[lo]) == 0;
+  return lo;
+}
+
+static int btree_innerSearch (BTree this1,BtNode node,void *value) {
+  // returns the index of the child whose range contains 'value'
+  int lo = 0,hi = node->n,mid;
+
+  while (lo < hi) {
+    mid = (lo + hi) / 2;
+    if (this1->compareFunction (value,node->keys[mid]) >= 0)
+      lo = mid + 1;
+    else
+      hi = mid;
+  }
+  return lo;
+}
+
+static BtNode btree_findLeaf (BTree this1,void *value,
+                              BtNode *path,int *idx,int *depth) {
+  // descends to the leaf for 'value'; records the path if path != NULL
+  BtNode node = (BtNode)this1->root;
+  int d = 0,i;
+
+  while (!node->isLeaf) {
+    i = btree_innerSearch (this1,node,value);
+    if (path != NULL) {
+      path[d] = node;
+      idx[d] = i;
+    }
+    d++;
+    node = node->child[i];
+  }
+  if (depth != NULL)
+    *depth = d;
+  return node;
+}
+
+static BtNode btree_leftmostLeaf (BtNode node) {
+  while (!node->isLeaf)
+    node = node->child[0];
+  return node;
+}
+
+static BtNode btree_rightmostLeaf (BtNode node) {
+  while (!node->isLeaf)
+    node = node->child[node->n];
+  return node;
+}
+
+BTree btree_treeCreate (int (*cmpFunction)(void *,void *),
+                        void (*cleanFunction)(void *)) {
+  /**
+     Creates a BTree, registers pointers to cleanFunction() and
+     cmpFunction() and returns a pointer to the BTree structure.<br>
+     Postcondition: User is responsible to free the memory allocated
+                    by calling the function btree_treeDestroy().
+     @param[in] cmpFunction - compare function to order two values in the tree
+     @param[in] cleanFunction - clean function to describe how memory allocated
+                                to each value should be freed
+     @return new BTree
+  */
+  BTree this1 = (BTree)hlr_malloc (sizeof (struct _BTreeStruct_));
+  this1->root = btree_nodeCreate (1);
+  this1->compareFunction = cmpFunction;
+  this1->cleanFunction = cleanFunction;
+  this1->numValues = 0;
+  this1->height = 1;
+  return this1;
+}
+
+void btree_treeDestroyFunc (BTree this1) {
+  /**
+     Destroys the BTree and memory allocated to all the values as
+     defined by the cleanFunc() registered through btree_treeCreate()<br>
+     Note: This function is only for internal use. Function btree_treeDestroy()
+           should be used instead from outside the package.
+     @param[in] this1 - BTree that should be destroyed
+  */
+  btree_nodeDestroy ((BtNode)this1->root,this1->cleanFunction);
+  hlr_free (this1);
+}
+
+int btree_treeIsEmpty (BTree this1) {
+  /**
+     Checks if the BTree has no values
+     @param[in] this1 - a BTree
+     @return 1 if empty, else 0
+  */
+  return this1->numValues == 0;
+}
+
+int btree_treeInsert (BTree this1,void *valueToInsert,
+                      void (*modifyFunc)(void *,void *)) {
+  /**
+     Inserts a new value in the BTree.
+     @param[in] this1 - a BTree
+     @param[in] valueToInsert - a pointer to new value to insert
+     @param[in] modifyFunc - NULL or a function called with the value in
+                             the tree and valueToInsert if an equal value
+                             is already in the tree; valueToInsert is not
+                             stored then
+     @return 0 if found, else 1 if sucessfully inserted
+  */
+  BtNode path[BTREE_MAXHEIGHT];
+  int idx[BTREE_MAXHEIGHT];
+  BtNode cur,right,parent,newRoot;
+  void *sep;
+  int d,pos,found,m,i;
+
+  cur = btree_findLeaf (this1,valueToInsert,path,idx,&d);
+  pos = btree_leafSearch (this1,cur,valueToInsert,&found);
+  if (found) {
+    if (modifyFunc != NULL)
+      modifyFunc (cur->keys[pos],valueToInsert);
+    return 0;
+  }
+  memmove (cur->keys + pos + 1,cur->keys + pos,(cur->n - pos) * sizeof (void *));
+  cur->keys[pos] = valueToInsert;
+  cur->n++;
+  this1->numValues++;
+  while (cur->n > BTREE_ORDER) { // split, moving the upper half right
+    m = cur->n / 2;
+    if (cur->isLeaf) {
+      right = btree_nodeCreate (1);
+      right->n = cur->n - m;
+      memcpy (right->keys,cur->keys + m,right->n * sizeof (void *));
+      cur->n = m;
+      right->next = cur->next;
+      if (cur->next != NULL)
+        cur->next->prev = right;
+      cur->next = right;
+      right->prev = cur;
+      sep = right->keys[0];
+    }
+    else {
+      right = btree_nodeCreate (0);
+      sep = cur->keys[m];
+      right->n = cur->n - m - 1;
+      memcpy (right->keys,cur->keys + m + 1,right->n * sizeof (void *));
+      memcpy (right->child,cur->child + m + 1,(right->n + 1) * sizeof (BtNode));
+      cur->n = m;
+    }
+    if (d == 0) { // split the root: the tree grows by one level
+      if (this1->height == BTREE_MAXHEIGHT)
+        die ("btree_treeInsert: tree too high");
+      newRoot = btree_nodeCreate (0);
+      newRoot->n = 1;
+      newRoot->keys[0] = sep;
+      newRoot->child[0] = cur;
+      newRoot->child[1] = right;
+      this1->root = newRoot;
+      this1->height++;
+      break;
+    }
+    d--;
+    parent = path[d];
+    i = idx[d];
+    memmove (parent->keys + i + 1,parent->keys + i,
+             (parent->n - i) * sizeof (void *));
+    memmove (parent->child + i + 2,parent->child + i + 1,
+             (parent->n - i) * sizeof (BtNode));
+    parent->keys[i] = sep;
+    parent->child[i+1] = right;
+    parent->n++;
+    cur = parent;
+  }
+  return 1;
+}
+
+static void btree_borrowLeft (BtNode parent,int i,BtNode left,BtNode cur) {
+  // moves the last value or child of 'left' to the front of 'cur'
+  memmove (cur->keys + 1,cur->keys,cur->n * sizeof (void *));
+  if (cur->isLeaf) {
+    cur->keys[0] = left->keys[left->n-1];
+    parent->keys[i-1] = cur->keys[0];
+  }
+  else {
+    memmove (cur->child + 1,cur->child,(cur->n + 1) * sizeof (BtNode));
+    cur->keys[0] = parent->keys[i-1];
+    cur->child[0] = left->child[left->n];
+    parent->keys[i-1] = left->keys[left->n-1];
+  }
+  left->n--;
+  cur->n++;
+}
+
+static void btree_borrowRight (BtNode parent,int i,BtNode cur,BtNode right) {
+  // moves the first value or child of 'right' to the end of 'cur'
+  if (cur->isLeaf) {
+    cur->keys[cur->n] = right->keys[0];
+    memmove (right->keys,right->keys + 1,(right->n - 1) * sizeof (void *));
+    parent->keys[i] = right->keys[0];
+  }
+  else {
+    cur->keys[cur->n] = parent->keys[i];
+    cur->child[cur->n+1] = right->child[0];
+    parent->keys[i] = right->keys[0];
+    memmove (right->keys,right->keys + 1,(right->n - 1) * sizeof (void *));
+    memmove (right->child,right->child + 1,right->n * sizeof (BtNode));
+  }
+  right->n--;
+  cur->n++;
+}
+
+static void btree_merge (BtNode parent,int k) {
+  // merges child k+1 of 'parent' into child k
+  BtNode a = parent->child[k];
+  BtNode b = parent->child[k+1];
+
+  if (a->isLeaf) {
+    memcpy (a->keys + a->n,b->keys,b->n * sizeof (void *));
+    a->n += b->n;
+    a->next = b->next;
+    if (b->next != NULL)
+      b->next->prev = a;
+  }
+  else {
+    a->keys[a->n] = parent->keys[k];
+    memcpy (a->keys + a->n + 1,b->keys,b->n * sizeof (void *));
+    memcpy (a->child + a->n + 1,b->child,(b->n + 1) * sizeof (BtNode));
+    a->n += b->n + 1;
+  }
+  memmove (parent->keys + k,parent->keys + k + 1,
+           (parent->n - k - 1) * sizeof (void *));
+  memmove (parent->child + k + 1,parent->child + k + 2,
+           (parent->n - k - 1) * sizeof (BtNode));
+  parent->n--;
+  hlr_free (b);
+}
+
+int btree_treeDelete (BTree this1,void *valueToDelete) {
+  /**
+     Deletes the value equal to valueToDelete from the BTree, calling
+     the cleanFunction on it
+     @param[in] this1 - a BTree
+     @param[in] valueToDelete - a pointer to value to delete
+     @return 0 if not found, else 1 if sucessfully deleted
+  */
+  BtNode path[BTREE_MAXHEIGHT];
+  int idx[BTREE_MAXHEIGHT];
+  BtNode cur,parent,left,right,node;
+  void *value;
+  int d,pos,found,i;
+
+  cur = btree_findLeaf (this1,valueToDelete,path,idx,&d);
+  pos = btree_leafSearch (this1,cur,valueToDelete,&found);
+  if (!found)
+    return 0;
+  value = cur->keys[pos];
+  memmove (cur->keys + pos,cur->keys + pos + 1,(cur->n - pos - 1) * sizeof (void *));
+  cur->n--;
+  this1->numValues--;
+  while (d > 0 && cur->n < BTREE_MIN) {
+    parent = path[d-1];
+    i = idx[d-1];
+    left = i > 0 ? parent->child[i-1] : NULL;
+    right = i < parent->n ? parent->child[i+1] : NULL;
+    if (left != NULL && left->n > BTREE_MIN) {
+      btree_borrowLeft (parent,i,left,cur);
+      break;
+    }
+    if (right != NULL && right->n > BTREE_MIN) {
+      btree_borrowRight (parent,i,cur,right);
+      break;
+    }
+    btree_merge (parent,left != NULL ? i - 1 : i);
+    cur = parent;
+    d--;
+  }
+  node = (BtNode)this1->root;
+  if (!node->isLeaf && node->n == 0) { // the tree shrinks by one level
+    this1->root = node->child[0];
+    hlr_free (node);
+    this1->height--;
+  }
+  /* the key equal to the deleted value, if any, is on its search path;
+     it becomes the new smallest value of its right subtree */
+  node = (BtNode)this1->root;
+  while (!node->isLeaf) {
+    i = btree_innerSearch (this1,node,value);
+    if (i > 0 && node->keys[i-1] == value)
+      node->keys[i-1] = btree_leftmostLeaf (node->child[i])->keys[0];
+    node = node->child[i];
+  }
+  this1->cleanFunction (value);
+  return 1;
+}
+
+int btree_treeFind (BTree this1,void *valueToFind,void **valueFound) {
+  /**
+     Finds the value equal to valueToFind in the BTree
+     @param[in] this1 - a BTree
+     @param[in] valueToFind - a pointer to value to search for; it should
+                              at least have the parts compared by the
+                              compare function
+     @param[out] valueFound - the value found in the tree
+     @return 0 if not found, else 1 if sucessfully found
+  */
+  BtNode leaf = btree_findLeaf (this1,valueToFind,NULL,NULL,NULL);
+  int found;
+  int pos = btree_leafSearch (this1,leaf,valueToFind,&found);
+
+  if (!found)
+    return 0;
+  *valueFound = leaf->keys[pos];
+  return 1;
+}
+
+int btree_treeFindMin (BTree this1,void **valueFound) {
+  /**
+     Finds the smallest value in the BTree
+     @param[in] this1 - a BTree
+     @param[out] valueFound - the value
+     @return 0 if the tree is empty, else 1
+  */
+  BtNode leaf = btree_leftmostLeaf ((BtNode)this1->root);
+
+  if (leaf->n == 0)
+    return 0;
+  *valueFound = leaf->keys[0];
+  return 1;
+}
+
+int btree_treeFindMax (BTree this1,void **valueFound) {
+  /**
+     Finds the largest value in the BTree
+     @param[in] this1 - a BTree
+     @param[out] valueFound - the value
+     @return 0 if the tree is empty, else 1
+  */
+  BtNode leaf = btree_rightmostLeaf ((BtNode)this1->root);
+
+  if (leaf->n == 0)
+    return 0;
+  *valueFound = leaf->keys[leaf->n-1];
+  return 1;
+}
+
+void *btree_treeNextValue (BTree this1,void *currVal,int *foundFlag) {
+  /**
+     Returns the value following currVal in increasing order;
+     currVal need not be in the tree.
+     @param[in] this1 - a BTree
+     @param[in] currVal - current value for which a successor value is desired
+     @param[out] foundFlag - set to 1 if currVal was found in the tree,
+                             else 0
+     @return the smallest value greater than currVal; NULL if none
+  */
+  BtNode leaf = btree_findLeaf (this1,currVal,NULL,NULL,NULL);
+  int pos = btree_leafSearch (this1,leaf,currVal,foundFlag);
+
+  if (*foundFlag)
+    pos++;
+  if (pos >= leaf->n) {
+    if ((leaf = leaf->next) == NULL)
+      return NULL;
+    pos = 0;
+  }
+  return leaf->keys[pos];
+}
+
+void *btree_treePrevValue (BTree this1,void *currVal,int *foundFlag) {
+  /**
+     Returns the value preceding currVal in increasing order;
+     currVal need not be in the tree.
+     @param[in] this1 - a BTree
+     @param[in] currVal - current value for which a predecessor is desired
+     @param[out] foundFlag - set to 1 if currVal was found in the tree,
+                             else 0
+     @return the largest value smaller than currVal; NULL if none
+  */
+  BtNode leaf = btree_findLeaf (this1,currVal,NULL,NULL,NULL);
+  int pos = btree_leafSearch (this1,leaf,currVal,foundFlag) - 1;
+
+  if (pos < 0) {
+    if ((leaf = leaf->prev) == NULL)
+      return NULL;
+    pos = leaf->n - 1;
+  }
+  return leaf->keys[pos];
+}
+
+long btree_treeNumValues (BTree this1) {
+  /**
+     @param[in] this1 - a BTree
+     @return number of values in the tree
+  */
+  return this1->numValues;
+}
+
+int btree_treeHeight (BTree this1) {
+  /**
+     @param[in] this1 - a BTree
+     @return number of levels of the tree, 1 if all values are in one leaf
+  */
+  return this1->height;
+}
+
+static long btree_nodeCheck (BTree this1,BtNode node,int level,
+                             BtNode *lastLeaf,int *ok) {
+  // checks a subtree; returns the number of values in it
+  long count = 0;
+  int i;
+
+  if (node != this1->root && node->n < BTREE_MIN)
+    *ok = 0;
+  if (node->n > BTREE_ORDER)
+    *ok = 0;
+  if (node->isLeaf) {
+    if (level != this1->height || node->prev != *lastLeaf)
+      *ok = 0;
+    *lastLeaf = node;
+    for (i=1;i<node->n;i++)
+      if (this1->compareFunction (node->keys[i-1],node->keys[i]) >= 0)
+        *ok = 0;
+    return node->n;
+  }
+  for (i=0;i<=node->n;i++) {
+    if (i > 0 && node->keys[i-1] != btree_leftmostLeaf (node->child[i])->keys[0])
+      *ok = 0;
+    count += btree_nodeCheck (this1,node->child[i],level + 1,lastLeaf,ok);
+  }
+  return count;
+}
+
+int btree_treeIsConsistent (BTree this1) {
+  /**
+     Checks the structure of the BTree: order of values, fill of nodes,
+     keys, depth of leaves and their links
+     @param[in] this1 - a BTree
+     @return 1 if consistent, else 0
+  */
+  BtNode lastLeaf = NULL;
+  int ok = 1;
+  long count = btree_nodeCheck (this1,(BtNode)this1->root,1,&lastLeaf,&ok);
+
+  if (lastLeaf->next != NULL || count != this1->numValues)
+    ok = 0;
+  return ok;
+}
+
+//----- Functions for the BTree iterator
+
+static BTreeIterator btree_itNew (BtNode leaf,int pos) {
+  BTreeIterator newIterator = (BTreeIterator)hlr_malloc (sizeof (struct _BTreeIteratorStruct_));
+  newIterator->leaf = leaf->n > 0 ? leaf : NULL;
+  newIterator->pos = pos;
+  return newIterator;
+}
+
+BTreeIterator btree_itCreate (BTree this1) {
+  /**
+     Creates an iterator to access values in increasing order;
+     the tree must not be modified while iterating.<br>
+     Postcondition: User is responsible to free the memory allocated
+                    by calling the function btree_itDestroy().
+     @param[in] this1 - a BTree
+     @return pointer to new BTree iterator
+  */
+  return btree_itNew (btree_leftmostLeaf ((BtNode)this1->root),0);
+}
+
+BTreeIterator btree_itCreateRev (BTree this1) {
+  /**
+     Creates an iterator to access values in decreasing order,
+     using btree_itPrevValue()
+     @param[in] this1 - a BTree
+     @return pointer to new BTree iterator
+  */
+  BtNode leaf = btree_rightmostLeaf ((BtNode)this1->root);
+  return btree_itNew (leaf,leaf->n - 1);
+}
+
+BTreeIterator btree_itCreateAt (BTree this1,void *value) {
+  /**
+     Creates an iterator starting at the smallest value not smaller than
+     'value', e.g. for range scans with btree_itNextValue()
+     @param[in] this1 - a BTree
+     @param[in] value - where to start; need not be in the tree
+     @return pointer to new BTree iterator
+  */
+  BtNode leaf = btree_findLeaf (this1,value,NULL,NULL,NULL);
+  int found;
+  int pos = btree_leafSearch (this1,leaf,value,&found);
+  BTreeIterator it = btree_itNew (leaf,pos);
+
+  if (it->leaf != NULL && pos >= leaf->n) {
+    it->leaf = leaf->next;
+    it->pos = 0;
+  }
+  return it;
+}
+
+void btree_itDestroyFunc (BTreeIterator this1) {
+  /**
+     Destroys the BTree iterator.<br>
+     Note: This function is only for internal use. Function btree_itDestroy()
+     should be used instead from outside the package.
+     @param[in] this1 - a BTree iterator
+  */
+  hlr_free (this1);
+}
+
+void *btree_itNextValue (BTreeIterator this1) {
+  /**
+     Returns the current value and moves the iterator to the next one
+     in increasing order
+     @param[in] this1 - a BTree iterator
+     @return the value; NULL if there is none
+  */
+  BtNode leaf = (BtNode)this1->leaf;
+  void *value;
+
+  if (leaf == NULL)
+    return NULL;
+  value = leaf->keys[this1->pos++];
+  if (this1->pos >= leaf->n) {
+    this1->leaf = leaf->next;
+    this1->pos = 0;
+  }
+  return value;
+}
+
+void *btree_itPrevValue (BTreeIterator this1) {
+  /**
+     Returns the current value and moves the iterator to the previous one
+     in increasing order
+     @param[in] this1 - a BTree iterator
+     @return the value; NULL if there is none
+  */
+  BtNode leaf = (BtNode)this1->leaf;
+  void *value;
+
+  if (leaf == NULL)
+    return NULL;
+  value = leaf->keys[this1->pos--];
+  if (this1->pos < 0) {
+    this1->leaf = leaf->prev;
+    this1->pos = leaf->prev != NULL ? leaf->prev->n - 1 : 0;
+  }
+  return value;
+}
+
+BTreeIterator btree_itCopy (BTreeIterator this1) {
+  /**
+     Makes a copy of an iterator
+     @param[in] this1 - a BTree iterator
+     @return new iterator at the same position
+  */
+  BTreeIterator newIterator = (BTreeIterator)hlr_malloc (sizeof (struct _BTreeIteratorStruct_));
+  *newIterator = *this1;
+  return newIterator;
+}
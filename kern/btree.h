@@ -0,0 +1,77 @@
+/*****************************************************************************
+* (c) Copyright 2012-2013 F.Hoffmann-La Roche AG                             *
+* Contact: bioinfoc@bioinfoc.ch, Detlef.Wolf@Roche.com.                      *
+*                                                                            *
+* This file is part of BIOINFO-C. BIOINFO-C is free software: you can        *
+* redistribute it and/or modify it under the terms of the GNU Lesser         *
+* General Public License as published by the Free Software Foundation,       *
+* either version 3 of the License, or (at your option) any later version.    *
+*                                                                            *
+* BIOINFO-C is distributed in the hope that it will be useful, but           *
+* WITHOUT ANY WARRANTY; without even the implied warranty of                 *
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU          *
+* Lesser General Public License for more details. You should have            *
+* received a copy of the GNU Lesser General Public License along with        *
+* BIOINFO-C. If not, see <http://www.gnu.org/licenses/>.                     *
+*****************************************************************************/
+/** @file btree.h
+    @brief Module for ordered sets in B+-trees, an alternative to AvlTree
+    for large sets: many values per node and linked leaves make lookups
+    and ordered scans cache friendly.
+    Module prefix btree_
+*/
+#ifndef BTREE_H
+#define BTREE_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/// the BTree object
+typedef struct _BTreeStruct_ {
+  void *root; //!< root node, a leaf while the tree is small
+  int (*compareFunction)(void *,void *); //!< function to use to compare values
+  void (*cleanFunction)(void *); //!< function to use to clean values
+  long numValues; //!< number of values in the tree
+  int height; //!< number of levels, 1 if the root is a leaf
+}*BTree;
+
+/// the BTreeIterator object
+typedef struct _BTreeIteratorStruct_ {
+  void *leaf; //!< leaf of the current value, NULL at the end
+  int pos; //!< position of the current value in the leaf
+}*BTreeIterator;
+
+extern BTree btree_treeCreate (int (*cmpFunction)(void *,void *),
+                               void (*cleanFunction)(void *));
+extern void btree_treeDestroyFunc (BTree this1);
+/// call this macro not the function btree_treeDestroyFunc()
+#define btree_treeDestroy(x) ((x) ? btree_treeDestroyFunc(x),x=NULL,1:0)
+extern int btree_treeIsEmpty (BTree this1);
+extern int btree_treeIsConsistent (BTree this1);
+extern int btree_treeDelete (BTree this1,void *valueToDelete);
+extern int btree_treeInsert (BTree this1,void *valueToInsert,
+                             void (*modifyFunc)(void *,void *));
+extern int btree_treeFind (BTree this1,void *valueToFind,void **valueFound);
+extern int btree_treeFindMin (BTree this1,void **valueFound);
+extern int btree_treeFindMax (BTree this1,void **valueFound);
+extern void *btree_treeNextValue (BTree this1,void *currVal,int *foundFlag);
+extern void *btree_treePrevValue (BTree this1,void *currVal,int *foundFlag);
+extern long btree_treeNumValues (BTree this1);
+extern int btree_treeHeight (BTree this1);
+
+extern BTreeIterator btree_itCreate (BTree this1);
+extern BTreeIterator btree_itCreateRev (BTree this1);
+extern BTreeIterator btree_itCreateAt (BTree this1,void *value);
+extern void btree_itDestroyFunc (BTreeIterator this1);
+/// call this macro not the function btree_itDestroyFunc()
+#define btree_itDestroy(x) ((x) ? btree_itDestroyFunc(x),x=NULL,1 : 0)
+extern void *btree_itNextValue (BTreeIterator this1);
+extern void *btree_itPrevValue (BTreeIterator this1);
+extern BTreeIterator btree_itCopy (BTreeIterator this1);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -27,6 +27,9 @@
 */
 #include <ctype.h>
 #include <stdint.h>
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
 #include "hlrmisc.h"
 #include "log.h"
 #include "format.h"
@@ -808,8 +811,9 @@ void textClear (Texta a) {
      @param[out] a - the Texta memory freed and zero elements
   */
   int i = arrayMax (a);
-  while (i-- > 0)
-    hlr_free (textItem (a,i));
+  if (a->arena == NULL) // strings of a Texta in an arena belong to the arena
+    while (i-- > 0)
+      hlr_free (textItem (a,i));
   arrayClear (a);
 }
 
@@ -1623,3 +1627,112 @@ char *wordNextG (WordIter this1,int *lenP) {
   }
   return word;
 }
+
+static void strSliceAdd (Array slices,int start,int len,int manySepsAreOne) {
+  StrSlice *sl;
+
+  if (manySepsAreOne && len == 0)
+    return;
+  sl = arrayp (slices,arrayMax (slices),StrSlice);
+  sl->start = start;
+  sl->len = len;
+}
+
+#ifdef __SSE2__
+static int lowestBit (unsigned int mask) {
+  /**
+     @return index of the lowest bit set in mask, which is not 0
+  */
+#ifdef __GNUC__
+  return __builtin_ctz (mask);
+#else
+  int i = 0;
+
+  while ((mask & 1) == 0) {
+    mask >>= 1;
+    i++;
+  }
+  return i;
+#endif
+}
+#endif
+
+int strSliceFields (char *s,int len,char *seps,int manySepsAreOne,
+                    Array slices) {
+  /**
+     Splits 's' into fields like wordIterCreate()/wordNext(), but
+     without copying, modifying or allocating anything per field:
+     the (start, length) of each field is written into 'slices',
+     which can be reused for many lines and only grows when a line has
+     more fields than any before.<br>
+     Usage:<br>
+     Array slices = arrayCreate (100,StrSlice);<br>
+     while ((line = ls_nextSpan (ls,&len)) != NULL) {<br>
+       n = strSliceFields (line,len,"\t",0,slices);<br>
+       for (i=0;i<n;i++) {<br>
+         StrSlice *f = arrp (slices,i,StrSlice);<br>
+         ... line + f->start, f->len ...<br>
+     }}<br>
+     arrayDestroy (slices);<br>
+     With up to 4 separator chars, the separators are searched 16 bytes
+     at a time where SSE2 is available.
+     @param[in] s - string to split; need not be '\0'-terminated if
+                    'len' is given
+     @param[in] len - number of chars of 's'; -1 for strlen(s)
+     @param[in] seps - set of separator chars, not empty
+     @param[in] manySepsAreOne - 0: each separator ends a field, so
+                                 n separators give n+1 fields, possibly
+                                 empty (like textFieldtok());
+                                 1: only non-empty fields (like
+                                 textStrtok())
+     @param[in] slices - an Array of StrSlice
+     @param[out] slices - the fields, previous contents are removed
+     @return number of fields, arrayMax(slices)
+  */
+  unsigned char isSep[256];
+  int nSeps,i,start;
+  char *cp;
+
+  if (s == NULL || seps == NULL || *seps == '\0')
+    die ("strSliceFields: some null/empty input");
+  if (len < 0)
+    len = strlen (s);
+  nSeps = strlen (seps);
+  arraySetMax (slices,0);
+  i = 0;
+  start = 0;
+#ifdef __SSE2__
+  if (nSeps <= 4) {
+    __m128i c0 = _mm_set1_epi8 (seps[0]);
+    __m128i c1 = _mm_set1_epi8 (seps[nSeps > 1 ? 1 : 0]);
+    __m128i c2 = _mm_set1_epi8 (seps[nSeps > 2 ? 2 : 0]);
+    __m128i c3 = _mm_set1_epi8 (seps[nSeps > 3 ? 3 : 0]);
+    __m128i v;
+    unsigned int mask;
+    int pos;
+
+    for (;i+16<=len;i+=16) {
+      v = _mm_loadu_si128 ((__m128i *)(s + i));
+      mask = (unsigned int)_mm_movemask_epi8 (
+        _mm_or_si128 (_mm_or_si128 (_mm_cmpeq_epi8 (v,c0),_mm_cmpeq_epi8 (v,c1)),
+                      _mm_or_si128 (_mm_cmpeq_epi8 (v,c2),_mm_cmpeq_epi8 (v,c3))));
+      while (mask != 0) {
+        pos = i + lowestBit (mask);
+        mask &= mask - 1;
+        strSliceAdd (slices,start,pos - start,manySepsAreOne);
+        start = pos + 1;
+      }
+    }
+  }
+#endif
+  memset (isSep,0,sizeof (isSep));
+  for (cp=seps;*cp!='\0';cp++)
+    isSep[(unsigned char)*cp] = 1;
+  for (;i<len;i++)
+    if (isSep[(unsigned char)s[i]]) {
+      strSliceAdd (slices,start,i - start,manySepsAreOne);
+      start = i + 1;
+    }
+  strSliceAdd (slices,start,len - start,manySepsAreOne);
+  return arrayMax (slices);
+}
@@ -374,6 +374,19 @@ char *wordNextG (WordIter this1,int *lenP);
 */
 #define wordNext(this1) (wordNextG((this1),NULL))
 
+/* --- split a string into slices without copying or modifying it --- */
+/**
+   A field of a string found by strSliceFields(): the field is
+   s[start..start+len-1]
+*/
+typedef struct {
+  int start; //!< offset of the first char of the field
+  int len; //!< number of chars in the field
+}StrSlice;
+
+extern int strSliceFields (char *s,int len,char *seps,int manySepsAreOne,
+                           Array slices);
+
 #ifdef __cplusplus
 }
 #endif
@@ -17,7 +17,33 @@
 /** @file hash.c
     @brief Hash table routines.
     Module prefix hash_
+    <br>
+    A HashTable keeps its number of sub tables unless growth is turned
+    on with hash_tableSetMaxLoad(); it then grows when it holds more than
+    maxLoad elements per sub table on average. Growing is incremental:
+    a new set of twice as many sub tables is allocated and each insertion
+    or deletion moves the contents of a few old sub tables into it, so
+    no single call pays for rehashing the whole table. Lookups consult
+    the old sub table of a value as long as it has not been moved.
+    This requires the selector function to work for any tableSize, and
+    the order of iteration changes while the table grows.
+    <br>
+    hash_selectString(), hash_selectStringPtr(), hash_selectInt() and
+    hash_selectPointer() are ready-made selector functions; they are based
+    on hash_bytes(), a fast hash function of the wyhash family.
+    <br>
+    A HashTableMT (hash_tableMT* functions) can be filled from several
+    threads at once: it consists of numShards HashTables, each protected
+    by its own lock, and a value goes to the shard chosen by its hash.
+    Threads thus rarely wait for each other, and modifyDuplicate() of
+    hash_tableMTInsert() runs under the lock of the shard, which makes
+    insert-or-update (e.g. counting) atomic.
 */
+#include "plabla.h"
+#include <string.h>
+#ifdef PLABLA_HAVE_PTHREAD
+#include <pthread.h>
+#endif
 #include "log.h"
 #include "hlrmisc.h"
 #include "hash.h"
@@ -25,6 +51,15 @@
 /// default value for hash table size
 #define DEFAULT_HASH_SIZE 4096
 
+/// maximal mean number of elements per sub table of HashTableMT shards
+#define MT_MAX_LOAD 4.0
+
+/// number of old sub tables moved per insertion or deletion while growing
+#define REHASH_STEP 4
+
+/// default number of shards of a HashTableMT
+#define DEFAULT_NUM_SHARDS 64
+
 HashTable hash_tableCreate (int tableSize,
                             int (*tableSelectorFunction)(void *,int),
                             int (*intraTableOrderFunction)(void *,void *),
@@ -66,9 +101,116 @@ HashTable hash_tableCreate (int tableSize,
                                         newTable->cleanFunction);
   }
   newTable->numElements = 0;
+  newTable->maxLoad = 0; // fixed size unless hash_tableSetMaxLoad()
+  newTable->oldSubTable = NULL;
+  newTable->oldTableSize = 0;
+  newTable->rehashIndex = 0;
   return newTable;
 }
 
+static void noClean (void *value) {
+  /**
+     Clean function for AvlTrees whose values have been moved elsewhere
+  */
+}
+
+static AvlTree oldTree (HashTable this1,void *value) {
+  /**
+     @return the old AvlTree 'value' belongs to if it has not been moved
+             yet, else NULL
+  */
+  int t;
+
+  if (this1->oldSubTable == NULL)
+    return NULL;
+  t = this1->tableSelectorFunction (value,this1->oldTableSize);
+  if (t < this1->rehashIndex ||
+      avl_treeIsEmpty (this1->oldSubTable[t].tablePt))
+    return NULL;
+  return this1->oldSubTable[t].tablePt;
+}
+
+static AvlTree anyTree (HashTable this1,int i) {
+  /**
+     Access to the new and the not yet moved old sub tables by one index
+     @param[in] i - 0 .. this1->tableSize + this1->oldTableSize - 1
+     @return the AvlTree; NULL if it is empty or has been moved
+  */
+  AvlTree tree;
+
+  if (i < this1->tableSize)
+    tree = this1->subTable[i].tablePt;
+  else if (i - this1->tableSize >= this1->rehashIndex)
+    tree = this1->oldSubTable[i - this1->tableSize].tablePt;
+  else
+    return NULL;
+  return avl_treeIsEmpty (tree) ? NULL : tree;
+}
+
+static void rehashStep (HashTable this1) {
+  /**
+     Move the contents of up to REHASH_STEP old sub tables into the new
+     ones; free the old sub tables when done
+  */
+  int n = 0;
+  AvlTree tree;
+  AvlIterator it;
+  void *value;
+  int t;
+
+  while (n < REHASH_STEP && this1->rehashIndex < this1->oldTableSize) {
+    tree = this1->oldSubTable[this1->rehashIndex].tablePt;
+    if (!avl_treeIsEmpty (tree)) {
+      it = avl_itCreate (tree);
+      while ((value = avl_itNextValue (it)) != NULL) {
+        t = this1->tableSelectorFunction (value,this1->tableSize);
+        avl_treeInsert (this1->subTable[t].tablePt,value,NULL);
+      }
+      avl_itDestroy (it);
+      n++;
+    }
+    tree->cleanFunction = noClean;
+    avl_treeDestroy (tree);
+    this1->oldSubTable[this1->rehashIndex].tablePt = NULL;
+    this1->rehashIndex++;
+  }
+  if (this1->rehashIndex == this1->oldTableSize) {
+    hlr_free (this1->oldSubTable);
+    this1->oldSubTable = NULL;
+    this1->oldTableSize = 0;
+    this1->rehashIndex = 0;
+  }
+}
+
+static void rehashStart (HashTable this1) {
+  /**
+     Start moving the elements into twice as many sub tables
+  */
+  int i;
+
+  this1->oldSubTable = this1->subTable;
+  this1->oldTableSize = this1->tableSize;
+  this1->rehashIndex = 0;
+  this1->tableSize *= 2;
+  this1->subTable = (HashSubTable *)hlr_malloc (this1->tableSize*sizeof (HashSubTable));
+  for (i=0;i<this1->tableSize;i++)
+    this1->subTable[i].tablePt = avl_treeCreate (this1->intraTableOrderFunction,
+                                                 this1->cleanFunction);
+}
+
+void hash_tableSetMaxLoad (HashTable this1,double maxLoad) {
+  /**
+     Turns on growth of a HashTable: it grows when it holds more than
+     maxLoad elements per sub table on average; 4 is a good choice.
+     By default a HashTable does not grow. Only turn growth on if the
+     selector function works for any tableSize, like hash_selectString()
+     etc., and no iterator is in use while inserting or deleting.
+     @param[in] this1 - a HashTable
+     @param[in] maxLoad - the maximal load; 0 means the table never grows
+  */
+  this1->maxLoad = maxLoad > 0 ? maxLoad : 0;
+}
+
 void hash_tableDestroyFunc (HashTable this1) {
   /**
     Destroys the HashTable and memory allocated to all the entries as
@@ -87,6 +229,9 @@ void hash_tableDestroyFunc (HashTable this1) {
     avl_treeDestroy (tableTmp->tablePt);
   }
   hlr_free (this1->subTable);
+  for (i=this1->rehashIndex;i<this1->oldTableSize;i++)
+    avl_treeDestroy (this1->oldSubTable[i].tablePt);
+  hlr_free (this1->oldSubTable);
   hlr_free (this1);
 }
 
@@ -106,6 +251,16 @@ int hash_tableInsert (HashTable this1,void *valueInsert,
      @return 0 if value found, else 1 if sucessfully inserted
   */
   int t;
+  void *valueFound;
+  AvlTree old;
+
+  if (this1->oldSubTable != NULL)
+    rehashStep (this1);
+  if ((old = oldTree (this1,valueInsert)) != NULL &&
+      avl_treeFind (old,valueInsert,&valueFound)) {
+    modifyDuplicate (valueFound,valueInsert);
+    return 0;
+  }
   t = this1->tableSelectorFunction (valueInsert,this1->tableSize);
   HashSubTable *tableTmp = this1->subTable+t;
   int insertFlag = avl_treeInsert (tableTmp->tablePt,valueInsert,
@@ -113,6 +268,10 @@ int hash_tableInsert (HashTable this1,void *valueInsert,
   if (insertFlag == 0)
     return 0;
   this1->numElements++;
+  if (this1->maxLoad > 0 && this1->oldSubTable == NULL &&
+      this1->numElements > this1->maxLoad * this1->tableSize &&
+      this1->tableSize <= (1 << 28))
+    rehashStart (this1);
   return 1;
 }
 
@@ -131,6 +290,11 @@ int hash_tableFind (HashTable this1,void *valueToFind,void **valueFound) {
      @return 0 if not found, else 1 if found
   */
   int t;
+  AvlTree old;
+
+  if ((old = oldTree (this1,valueToFind)) != NULL &&
+      avl_treeFind (old,valueToFind,valueFound))
+    return 1;
   t = this1->tableSelectorFunction (valueToFind,this1->tableSize);
   HashSubTable *tableTmp = this1->subTable+t;
   if (avl_treeIsEmpty (tableTmp->tablePt))
@@ -151,6 +315,15 @@ int hash_tableDelete (HashTable this1,void *valueToDelete) {
      @return 0 if not found, else 1 if sucessfully deleted
   */
   int t;
+  AvlTree old;
+
+  if (this1->oldSubTable != NULL)
+    rehashStep (this1);
+  if ((old = oldTree (this1,valueToDelete)) != NULL &&
+      avl_treeDelete (old,valueToDelete)) {
+    this1->numElements--;
+    return 1;
+  }
   t = this1->tableSelectorFunction (valueToDelete,this1->tableSize);
   HashSubTable *tableTmp = this1->subTable+t;
   if (avl_treeIsEmpty (tableTmp->tablePt))
@@ -171,13 +344,14 @@ void hash_tablePrintStats (HashTable this1,FILE *outFile) {
                           Use stdout to print on terminal window.
   */
   int i;
-  for (i=0;i<this1->tableSize;i++) {
-    HashSubTable *tableTmp = this1->subTable+i;
-    if (!avl_treeIsEmpty (tableTmp->tablePt))
-      fprintf (outFile,"Table:%d\tNum_Elem:%ld\theight:%d\n",
-               i,avl_treeNumNodes (tableTmp->tablePt),
-               avl_treeHeight (tableTmp->tablePt));
-  }
+  AvlTree tree;
+
+  for (i=0;i<this1->tableSize+this1->oldTableSize;i++)
+    if ((tree = anyTree (this1,i)) != NULL)
+      fprintf (outFile,"%sTable:%d\tNum_Elem:%ld\theight:%d\n",
+               i < this1->tableSize ? "" : "Old",
+               i < this1->tableSize ? i : i - this1->tableSize,
+               avl_treeNumNodes (tree),avl_treeHeight (tree));
 }
 
 void hash_tableApplyFunc (HashTable this1,void *applyFunc (),int nargs,...) {
@@ -196,15 +370,14 @@ void hash_tableApplyFunc (HashTable this1,void *applyFunc (),int nargs,...) {
                         variable arguments type casted to (void *)
   */
   int i;
+  AvlTree tree;
 
-  for (i=0;i<this1->tableSize;i++) {
-    HashSubTable *tableTmp = this1->subTable+i;
-    if (avl_treeIsEmpty (tableTmp->tablePt))
+  for (i=0;i<this1->tableSize+this1->oldTableSize;i++) {
+    if ((tree = anyTree (this1,i)) == NULL)
       continue;
     va_list args;
     va_start (args,nargs);
-    avl_treeApplyFuncFixedArgs (tableTmp->tablePt,(void (*)())applyFunc,
-                                nargs,args);
+    avl_treeApplyFuncFixedArgs (tree,(void (*)())applyFunc,nargs,args);
     va_end (args);
   }
 }
@@ -218,11 +391,387 @@ int hash_tableNumElem (HashTable this1) {
   return this1->numElements;
 }
 
+//----- Hash functions and ready-made table selectors
+
+/* hash_bytes() follows wyhash (final version 4) by Wang Yi, released
+   into the public domain: 64-bit multiply-and-fold mixing of 8-byte
+   words, with one branch-free path for keys up to 16 bytes */
+
+/// the secret constants of wyhash
+static const uint64_t wySecret[4] = {
+  0xa0761d6478bd642fULL,0xe7037ed1a0b428dbULL,
+  0x8ebc6af09c88c6e3ULL,0x589965cc75374cc3ULL
+};
+
+static void wyMum (uint64_t *a,uint64_t *b) {
+  /**
+     Replace a and b by the low and high 64 bits of their 128-bit product
+  */
+#ifdef __SIZEOF_INT128__
+  __uint128_t r = (__uint128_t)*a * *b;
+  *a = (uint64_t)r;
+  *b = (uint64_t)(r >> 64);
+#else
+  uint64_t ha = *a >> 32,hb = *b >> 32,la = (uint32_t)*a,lb = (uint32_t)*b;
+  uint64_t rh = ha * hb,rm0 = ha * lb,rm1 = hb * la,rl = la * lb;
+  uint64_t t = rl + (rm0 << 32),c = t < rl;
+  uint64_t lo = t + (rm1 << 32);
+  c += lo < t;
+  *a = lo;
+  *b = rh + (rm0 >> 32) + (rm1 >> 32) + c;
+#endif
+}
+
+static uint64_t wyMix (uint64_t a,uint64_t b) {
+  /**
+     @return high 64 bits xor low 64 bits of the 128-bit product a * b
+  */
+  wyMum (&a,&b);
+  return a ^ b;
+}
+
+static uint64_t wyRead8 (unsigned char *p) {
+  uint64_t v;
+  memcpy (&v,p,8);
+  return v;
+}
+
+static uint64_t wyRead4 (unsigned char *p) {
+  uint32_t v;
+  memcpy (&v,p,4);
+  return v;
+}
+
+uint64_t hash_bytes (void *p,int len) {
+  /**
+     Fast, high quality hash function of a sequence of bytes
+     (byte order dependent, so hash values should not be stored
+     in files read on other platforms)
+     @param[in] p - start of the bytes
+     @param[in] len - number of bytes
+     @return hash value
+  */
+  unsigned char *q = (unsigned char *)p;
+  uint64_t seed = wyMix (wySecret[0],wySecret[1]);  // seed 0
+  uint64_t a,b,see1,see2;
+  int i = len;
+
+  if (len <= 16) {
+    if (len >= 4) {
+      a = (wyRead4 (q) << 32) | wyRead4 (q + ((len >> 3) << 2));
+      b = (wyRead4 (q + len - 4) << 32) | wyRead4 (q + len - 4 - ((len >> 3) << 2));
+    }
+    else if (len > 0) {
+      a = ((uint64_t)q[0] << 16) | ((uint64_t)q[len >> 1] << 8) | q[len - 1];
+      b = 0;
+    }
+    else
+      a = b = 0;
+  }
+  else {
+    if (i > 48) {
+      see1 = see2 = seed;
+      do {
+        seed = wyMix (wyRead8 (q) ^ wySecret[1],wyRead8 (q + 8) ^ seed);
+        see1 = wyMix (wyRead8 (q + 16) ^ wySecret[2],wyRead8 (q + 24) ^ see1);
+        see2 = wyMix (wyRead8 (q + 32) ^ wySecret[3],wyRead8 (q + 40) ^ see2);
+        q += 48;
+        i -= 48;
+      } while (i > 48);
+      seed ^= see1 ^ see2;
+    }
+    while (i > 16) {
+      seed = wyMix (wyRead8 (q) ^ wySecret[1],wyRead8 (q + 8) ^ seed);
+      q += 16;
+      i -= 16;
+    }
+    a = wyRead8 (q + i - 16);
+    b = wyRead8 (q + i - 8);
+  }
+  a ^= wySecret[1];
+  b ^= seed;
+  wyMum (&a,&b);
+  return wyMix (a ^ wySecret[0] ^ (uint64_t)len,b ^ wySecret[1]);
+}
+
+uint64_t hash_string (char *s) {
+  /**
+     Hash function of a string, see hash_bytes()
+     @param[in] s - '\0'-terminated string
+     @return hash value
+  */
+  return hash_bytes (s,strlen (s));
+}
+
+uint64_t hash_int64 (uint64_t x) {
+  /**
+     Hash function of an integer; mixes all input bits into all output
+     bits, so that consecutive numbers get unrelated hash values
+     @param[in] x - the number
+     @return hash value
+  */
+  return wyMix (x ^ wySecret[0],wySecret[1]);
+}
+
+static int hashReduce (uint64_t h,int tableSize) {
+  /**
+     Map a hash value onto 0 .. tableSize-1 without division
+  */
+  return (int)(((h >> 32) * (uint64_t)tableSize) >> 32);
+}
+
+int hash_selectString (void *value,int tableSize) {
+  /**
+     Table selector function for values which are strings
+     (char *, or pointers to structs starting with a char array)
+     @param[in] value - the value
+     @param[in] tableSize - number of sub tables
+     @return sub table index
+  */
+  return hashReduce (hash_string ((char *)value),tableSize);
+}
+
+int hash_selectStringPtr (void *value,int tableSize) {
+  /**
+     Table selector function for values which are pointers to structs
+     whose first member is a char * holding the key
+     @param[in] value - the value
+     @param[in] tableSize - number of sub tables
+     @return sub table index
+  */
+  return hashReduce (hash_string (*(char **)value),tableSize);
+}
+
+int hash_selectInt (void *value,int tableSize) {
+  /**
+     Table selector function for values which are pointers to int
+     (or to structs whose first member is an int holding the key)
+     @param[in] value - the value
+     @param[in] tableSize - number of sub tables
+     @return sub table index
+  */
+  return hashReduce (hash_int64 ((uint64_t)(unsigned int)*(int *)value),
+                     tableSize);
+}
+
+int hash_selectPointer (void *value,int tableSize) {
+  /**
+     Table selector function for tables whose values are compared by
+     their address
+     @param[in] value - the value
+     @param[in] tableSize - number of sub tables
+     @return sub table index
+  */
+  return hashReduce (hash_int64 ((uint64_t)(uintptr_t)value),tableSize);
+}
+
+//----- HashTableMT: a HashTable for use from several threads
+
+#ifdef PLABLA_HAVE_PTHREAD
+/// a lock on its own cache line, so that locks of shards do not interfere
+typedef union {
+  pthread_mutex_t mutex; //!< the lock
+  char pad[64]; //!< padding to a cache line
+}ShardLock;
+#endif
+
+static int shardOf (HashTableMT this1,void *value) {
+  /**
+     @return the shard 'value' belongs to; derived from the selector
+             function by rehashing, so that the choice of shard is
+             independent of the sub table within the shard
+  */
+  int t = this1->tableSelectorFunction (value,1 << 30);
+
+  return (int)(hash_int64 ((uint64_t)t) % (uint64_t)this1->numShards);
+}
+
+static void shardLock (HashTableMT this1,int i) {
+#ifdef PLABLA_HAVE_PTHREAD
+  pthread_mutex_lock (&((ShardLock *)this1->locks)[i].mutex);
+#endif
+}
+
+static void shardUnlock (HashTableMT this1,int i) {
+#ifdef PLABLA_HAVE_PTHREAD
+  pthread_mutex_unlock (&((ShardLock *)this1->locks)[i].mutex);
+#endif
+}
+
+HashTableMT hash_tableMTCreate (int numShards,int tableSize,
+                                int (*tableSelectorFunction)(void *,int),
+                                int (*intraTableOrderFunction)(void *,void *),
+                                void (*cleanFunction)(void *)) {
+  /**
+     Creates a hash table which can be used from several threads at the
+     same time; arguments as for hash_tableCreate().<br>
+     Postcondition: User is responsible to free the memory allocated
+     by calling the function hash_tableMTDestroy().
+     @param[in] numShards - number of independently locked HashTables;
+                            several times the number of threads is a good
+                            choice; -1 assigns a default value of 64
+     @param[in] tableSize - initial number of subtables per shard,
+                            -1 assigns a default value
+     @param[in] tableSelectorFunction - subtable selector function; must
+                                        work for any table size
+     @param[in] intraTableOrderFunction - compare function to order two entries
+                                          in a subtable
+     @param[in] cleanFunction - clean function to describe how memory allocated
+                                to each entry should be freed
+     @return new HashTableMT
+  */
+  HashTableMT this1 = (HashTableMT)hlr_malloc (sizeof (struct _HashTableMTStruct_));
+  int i;
+
+  this1->numShards = numShards < 1 ? DEFAULT_NUM_SHARDS : numShards;
+  if (tableSize < 1)
+    tableSize = DEFAULT_HASH_SIZE / 16;
+  this1->tableSelectorFunction = tableSelectorFunction;
+  this1->shards = (HashTable *)hlr_malloc (this1->numShards * sizeof (HashTable));
+  for (i=0;i<this1->numShards;i++) {
+    this1->shards[i] = hash_tableCreate (tableSize,tableSelectorFunction,
+                                         intraTableOrderFunction,cleanFunction);
+    hash_tableSetMaxLoad (this1->shards[i],MT_MAX_LOAD);
+  }
+#ifdef PLABLA_HAVE_PTHREAD
+  // aligned, so that each lock really has a cache line of its own
+  if (posix_memalign (&this1->locks,sizeof (ShardLock),
+                      this1->numShards * sizeof (ShardLock)) != 0)
+    die ("hash_tableMTCreate: out of memory");
+  for (i=0;i<this1->numShards;i++)
+    pthread_mutex_init (&((ShardLock *)this1->locks)[i].mutex,NULL);
+#else
+  this1->locks = NULL;
+#endif
+  return this1;
+}
+
+void hash_tableMTDestroyFunc (HashTableMT this1) {
+  /**
+     Destroys the HashTableMT and all its entries; no other thread may
+     use the table any more.<br>
+     Note: This function is only for internal use. Function
+           hash_tableMTDestroy() should be used instead.
+     @param[in] this1 - HashTableMT that should be destroyed
+  */
+  int i;
+
+  for (i=0;i<this1->numShards;i++) {
+    hash_tableDestroy (this1->shards[i]);
+#ifdef PLABLA_HAVE_PTHREAD
+    pthread_mutex_destroy (&((ShardLock *)this1->locks)[i].mutex);
+#endif
+  }
+#ifdef PLABLA_HAVE_PTHREAD
+  free (this1->locks); // from posix_memalign()
+#endif
+  hlr_free (this1->shards);
+  hlr_free (this1);
+}
+
+int hash_tableMTInsert (HashTableMT this1,void *valueInsert,
+                        void (*modifyDuplicate)(void *,void *)) {
+  /**
+     Inserts a new value; may be called from several threads at once.
+     modifyDuplicate() is called while the shard is locked, so it may
+     safely update the value found in the table.
+     @param[in] this1 - a HashTableMT
+     @param[in] valueInsert - a pointer to new value to insert
+     @param[in] modifyDuplicate - modifyFunc() to define what should be done
+                                  when the valueToInsert is already found on
+                                  the table.
+     @return 0 if value found, else 1 if sucessfully inserted
+  */
+  int i = shardOf (this1,valueInsert);
+  int r;
+
+  shardLock (this1,i);
+  r = hash_tableInsert (this1->shards[i],valueInsert,modifyDuplicate);
+  shardUnlock (this1,i);
+  return r;
+}
+
+int hash_tableMTFind (HashTableMT this1,void *valueToFind,void **valueFound) {
+  /**
+     Finds a value; may be called from several threads at once.<br>
+     Note: the value found may be modified by modifyDuplicate() of
+     concurrent insertions or freed by concurrent deletions
+     @param[in] this1 - a HashTableMT
+     @param[in] valueToFind - a pointer to value to search for
+     @param[out] valueFound - the value found in the table
+     @return 0 if not found, else 1 if found
+  */
+  int i = shardOf (this1,valueToFind);
+  int r;
+
+  shardLock (this1,i);
+  r = hash_tableFind (this1->shards[i],valueToFind,valueFound);
+  shardUnlock (this1,i);
+  return r;
+}
+
+int hash_tableMTDelete (HashTableMT this1,void *valueToDelete) {
+  /**
+     Deletes a value; may be called from several threads at once
+     @param[in] this1 - a HashTableMT
+     @param[in] valueToDelete - a pointer to value to delete
+     @return 0 if not found, else 1 if sucessfully deleted
+  */
+  int i = shardOf (this1,valueToDelete);
+  int r;
+
+  shardLock (this1,i);
+  r = hash_tableDelete (this1->shards[i],valueToDelete);
+  shardUnlock (this1,i);
+  return r;
+}
+
+int hash_tableMTNumElem (HashTableMT this1) {
+  /**
+     Returns the number of elements in the table; exact only if no other
+     thread modifies the table at the same time
+     @param[in] this1 - a HashTableMT
+     @return number of elements
+  */
+  int i,n = 0;
+
+  for (i=0;i<this1->numShards;i++) {
+    shardLock (this1,i);
+    n += hash_tableNumElem (this1->shards[i]);
+    shardUnlock (this1,i);
+  }
+  return n;
+}
+
+int hash_tableMTNumShards (HashTableMT this1) {
+  /**
+     @param[in] this1 - a HashTableMT
+     @return number of shards
+  */
+  return this1->numShards;
+}
+
+HashTable hash_tableMTShard (HashTableMT this1,int i) {
+  /**
+     Access to the HashTables making up a HashTableMT, e.g. to iterate
+     over all values with hash_itCreate() once the threads are done;
+     every value is in exactly one shard.
+     @param[in] this1 - a HashTableMT
+     @param[in] i - number of the shard, 0..hash_tableMTNumShards()-1
+     @return the HashTable; it must not be used while other threads
+             use the HashTableMT
+  */
+  if (i < 0 || i >= this1->numShards)
+    die ("hash_tableMTShard: shard %d of %d",i,this1->numShards);
+  return this1->shards[i];
+}
+
 //----- Functions for hash Table Iterator
 
 HashIterator hash_itCreate (HashTable table) {
   /**
-     Creates an iterator to access elements stored on HashTable.<br>
+     Creates an iterator to access elements stored on HashTable;
+     the table must not be modified while iterating.<br>
      Precondition: hash_tableCreate() should be called before
                    calling this function
      Postcondition: User is responsible to free the memory allocated
@@ -231,14 +780,14 @@ HashIterator hash_itCreate (HashTable table) {
      @return Pointer to new HashTable iterator
   */
   int i;
+  AvlTree tree;
   HashIterator newIterator = (HashIterator)hlr_malloc (sizeof (struct _HashIteratorStruct_));
   newIterator->table = table;
   newIterator->currIterator = NULL;
   newIterator->currTableIndex = -1;
-  for (i=0;i<table->tableSize;i++) {
-    HashSubTable *tableTmp = table->subTable+i;
-    if (!avl_treeIsEmpty (tableTmp->tablePt)) {
-      newIterator->currIterator = avl_itCreate (tableTmp->tablePt);
+  for (i=0;i<table->tableSize+table->oldTableSize;i++) {
+    if ((tree = anyTree (table,i)) != NULL) {
+      newIterator->currIterator = avl_itCreate (tree);
       newIterator->currTableIndex = i;
       break;
     }
@@ -269,15 +818,16 @@ void *hash_itNextValue (HashIterator iterator) {
              NULL if no next element is found
   */
   int i;
+  AvlTree tree;
   if (iterator->currIterator == NULL)
     die ("hash_itCreate() should be used before using hash_itNextValue.");
   void *returnVal = avl_itNextValue (iterator->currIterator);
   if (returnVal == NULL) {
     avl_itDestroy (iterator->currIterator);
-    for (i=iterator->currTableIndex+1;i<iterator->table->tableSize;i++) {
-      HashSubTable *tableTmp = iterator->table->subTable+i;
-      if (!avl_treeIsEmpty (tableTmp->tablePt)) {
-        iterator->currIterator = avl_itCreate (tableTmp->tablePt);
+    for (i=iterator->currTableIndex+1;
+         i<iterator->table->tableSize+iterator->table->oldTableSize;i++) {
+      if ((tree = anyTree (iterator->table,i)) != NULL) {
+        iterator->currIterator = avl_itCreate (tree);
         iterator->currTableIndex = i;
         returnVal = avl_itNextValue (iterator->currIterator);
         break;
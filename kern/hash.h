@@ -25,6 +25,7 @@
 extern "C" {
 #endif
 
+#include <stdint.h>
 #include "avlTree.h"
 
 /// the HashSubTable structure
@@ -40,6 +41,10 @@ typedef struct _HashTableStruct_ {
   int (*tableSelectorFunction) (void *,int); //!< function to be used to select table
   int (*intraTableOrderFunction) (void *,void *); //!< function to be used to order the tables
   void (*cleanFunction) (void *); //!< function to be used to clean the table
+  double maxLoad; //!< grow when numElements exceeds maxLoad * tableSize; 0: never
+  HashSubTable *oldSubTable; //!< sub tables being moved into subTable, NULL if none
+  int oldTableSize; //!< number of old sub tables
+  int rehashIndex; //!< old sub tables before this one have been moved
 }*HashTable;
 
 /// the HashIter object
@@ -64,6 +69,39 @@ extern void hash_tablePrintStats (HashTable this1,FILE *outFile);
 extern void hash_tableApplyFunc (HashTable this1,void *applyFunc(),
                                  int nargs,...);
 extern int hash_tableNumElem (HashTable this1);
+extern void hash_tableSetMaxLoad (HashTable this1,double maxLoad);
+
+extern uint64_t hash_bytes (void *p,int len);
+extern uint64_t hash_string (char *s);
+extern uint64_t hash_int64 (uint64_t x);
+extern int hash_selectString (void *value,int tableSize);
+extern int hash_selectStringPtr (void *value,int tableSize);
+extern int hash_selectInt (void *value,int tableSize);
+extern int hash_selectPointer (void *value,int tableSize);
+
+/// the HashTableMT object: a HashTable usable from several threads
+typedef struct _HashTableMTStruct_ {
+  int numShards; //!< number of independently locked HashTables
+  HashTable *shards; //!< the HashTables
+  void *locks; //!< one lock per shard
+  int (*tableSelectorFunction) (void *,int); //!< as for the shards
+}*HashTableMT;
+
+extern HashTableMT hash_tableMTCreate (int numShards,int tableSize,
+                                       int (*tableSelectorFunction)(void *,int),
+                                       int (*intraTableOrderFunction)(void *,void *),
+                                       void (*cleanFunction)(void *));
+extern void hash_tableMTDestroyFunc (HashTableMT this1);
+/// use this macro, do not use hash_tableMTDestroyFunc()
+#define hash_tableMTDestroy(x) ((x) ? hash_tableMTDestroyFunc(x),x=NULL,1:0)
+extern int hash_tableMTInsert (HashTableMT this1,void *valueInsert,
+                               void (*modifyDuplicate)(void *,void *));
+extern int hash_tableMTFind (HashTableMT this1,void *valueToFind,
+                             void **valueFound);
+extern int hash_tableMTDelete (HashTableMT this1,void *valueToDelete);
+extern int hash_tableMTNumElem (HashTableMT this1);
+extern int hash_tableMTNumShards (HashTableMT this1);
+extern HashTable hash_tableMTShard (HashTableMT this1,int i);
 
 extern HashIterator hash_itCreate (HashTable table);
 extern void hash_itDestroyFunc (HashIterator iterator);
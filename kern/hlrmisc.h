@@ -27,6 +27,7 @@ extern "C" {
 
 #include <stdlib.h>
 #include <string.h>
+#include "plabla.h"
 
 extern char *hlr_strmcpyI (char *to,char *from,int toLength);
 
@@ -87,27 +88,40 @@ extern char *hlr_strdups (char *s1);
 #else
 // count allocations and check for allocation success
 
+#if defined(PLABLA_HAVE_PTHREAD) && defined(__GNUC__)
+// the counter may be updated from several threads at once
+#define hlr_allocCntInc() __atomic_add_fetch (&hlr_allocCnt,1,__ATOMIC_RELAXED)
+#define hlr_allocCntDec() __atomic_sub_fetch (&hlr_allocCnt,1,__ATOMIC_RELAXED)
+#else
+#define hlr_allocCntInc() (++hlr_allocCnt)
+#define hlr_allocCntDec() (--hlr_allocCnt)
+#endif
+
 /// free only when allocated and keep track of number of allocations
-#define hlr_free(x) ((x) ? free(x),--hlr_allocCnt,x=0,1 : 0)
+#define hlr_free(x) ((x) ? free(x),hlr_allocCntDec(),x=0,1 : 0)
 
 /// like strdup but keep track of number of allocations
-#define hlr_strdup(s) (++hlr_allocCnt,hlr_strdups(s))
+#define hlr_strdup(s) (hlr_allocCntInc(),hlr_strdups(s))
 
 /// like calloc but keep track of number of allocations
-#define hlr_calloc(nelem,elsize) (++hlr_allocCnt,hlr_callocs(nelem,elsize))
+#define hlr_calloc(nelem,elsize) (hlr_allocCntInc(),hlr_callocs(nelem,elsize))
 
 /// like malloc but keep track of number of allocations
-#define hlr_malloc(n) (++hlr_allocCnt,hlr_mallocs(n))
+#define hlr_malloc(n) (hlr_allocCntInc(),hlr_mallocs(n))
 
 /// keep track of memory allocated by external routines like gdbm_fetch()
-#define hlr_mallocExtern() (++hlr_allocCnt)
+#define hlr_mallocExtern() hlr_allocCntInc()
 #endif
 
 /// hlr_realloc identical to realloc
 #define hlr_realloc realloc
 
 /// Get the number of pending allocations
+#if defined(PLABLA_HAVE_PTHREAD) && defined(__GNUC__)
+#define hlr_getAllocCnt() __atomic_load_n (&hlr_allocCnt,__ATOMIC_RELAXED)
+#else
 #define hlr_getAllocCnt() hlr_allocCnt
+#endif
 
 /**
    Be careful with all of the following macros:
@@ -0,0 +1,153 @@
+/*****************************************************************************
+* (c) Copyright 2012-2013 F.Hoffmann-La Roche AG                             *
+* Contact: bioinfoc@bioinfoc.ch, Detlef.Wolf@Roche.com.                      *
+*                                                                            *
+* This file is part of BIOINFO-C. BIOINFO-C is free software: you can        *
+* redistribute it and/or modify it under the terms of the GNU Lesser         *
+* General Public License as published by the Free Software Foundation,       *
+* either version 3 of the License, or (at your option) any later version.    *
+*                                                                            *
+* BIOINFO-C is distributed in the hope that it will be useful, but           *
+* WITHOUT ANY WARRANTY; without even the implied warranty of                 *
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU          *
+* Lesser General Public License for more details. You should have            *
+* received a copy of the GNU Lesser General Public License along with        *
+* BIOINFO-C. If not, see <http://www.gnu.org/licenses/>.                     *
+*****************************************************************************/
+/** @file intern.c
+    @brief Module for string interning: each distinct string is stored
+    once and represented by one canonical pointer.
+    Module prefix intern_
+    <br>
+    Parsers reading tables see the same column names, sample IDs and
+    probe set IDs over and over; interning stores each of them once,
+    and two interned strings are equal if and only if their pointers
+    are equal:<br>
+    InternPool pool = intern_poolCreate (0);<br>
+    Texta t = textFieldtokInterned (pool,line,"\t");<br>
+    if (textItem (t,0) == intern_string (pool,"AFFX-BioB-5_at")) ...<br>
+    arrayDestroy (t);<br>
+    intern_poolDestroy (pool);<br>
+    Strings are kept in an Arena and found through an OhTable.
+    An InternPool must not be used by several threads at the same time.
+*/
+#include <string.h>
+#include "log.h"
+#include "hlrmisc.h"
+#include "hash.h"
+#include "intern.h"
+
+static unsigned int internHash (char *s) {
+  return (unsigned int)hash_string (s);
+}
+
+InternPool intern_poolCreate (int sizeHint) {
+  /**
+     Creates a pool of interned strings.<br>
+     Postcondition: User is responsible to free the memory allocated
+                    by calling intern_poolDestroy()
+     @param[in] sizeHint - expected number of distinct strings; 0 if
+                           unknown
+     @return new InternPool
+  */
+  InternPool this1 = (InternPool)hlr_malloc (sizeof (struct _internPoolStruct_));
+  this1->arena = arena_create (0);
+  this1->table = oht_tableCreate (sizeHint,(unsigned int (*)(void *))internHash,
+                                  (int (*)(void *,void *))strcmp,NULL);
+  return this1;
+}
+
+void intern_poolDestroyFunc (InternPool this1) {
+  /**
+     Destroys the pool; all strings interned become invalid.<br>
+     Note: This function is only for internal use. Use the macro
+     intern_poolDestroy() instead.
+     @param[in] this1 - an InternPool
+  */
+  oht_tableDestroy (this1->table);
+  arena_destroy (this1->arena);
+  hlr_free (this1);
+}
+
+char *intern_string (InternPool this1,char *s) {
+  /**
+     Returns the canonical copy of 's'
+     @param[in] this1 - an InternPool
+     @param[in] s - a string, not NULL
+     @return the string in the pool equal to 's', added if not yet
+             there; read-only, valid until the pool is destroyed
+  */
+  void *found;
+  char *copy;
+
+  if (oht_tableFind (this1->table,s,&found))
+    return (char *)found;
+  copy = arena_strdup (this1->arena,s);
+  oht_tableInsert (this1->table,copy,NULL);
+  return copy;
+}
+
+char *intern_find (InternPool this1,char *s) {
+  /**
+     Looks up 's' without adding it
+     @param[in] this1 - an InternPool
+     @param[in] s - a string, not NULL
+     @return the string in the pool equal to 's'; NULL if not there
+  */
+  void *found;
+  return oht_tableFind (this1->table,s,&found) ? (char *)found : NULL;
+}
+
+int intern_count (InternPool this1) {
+  /**
+     @param[in] this1 - an InternPool
+     @return number of distinct strings in the pool
+  */
+  return oht_tableNumElem (this1->table);
+}
+
+size_t intern_bytesGet (InternPool this1) {
+  /**
+     @param[in] this1 - an InternPool
+     @return number of bytes taken by the strings of the pool
+  */
+  return arena_bytesGet (this1->arena);
+}
+
+Texta textStrtokInterned (InternPool pool,char *s,char *sep) {
+  /**
+     Same as textStrtok() but the words are interned in 'pool'
+     @param[in] pool - an InternPool
+     @param[in] s - input string
+     @param[in] sep - separation character(s)
+     @param[out] s - the contents changed!
+     @return an Array of interned strings; free it with arrayDestroy()
+  */
+  WordIter wi = wordIterCreate (s,sep,1);
+  char *pos;
+
+  Texta a = textCreate (10);
+  while ((pos = wordNext (wi)) != NULL)
+    textAddInterned (pool,a,pos);
+  wordIterDestroy (wi);
+  return a;
+}
+
+Texta textFieldtokInterned (InternPool pool,char *s,char *sep) {
+  /**
+     Same as textFieldtok() but the fields are interned in 'pool'
+     @param[in] pool - an InternPool
+     @param[in] s - input string
+     @param[in] sep - separation character(s)
+     @param[out] s - the contents changed!
+     @return an Array of interned strings; free it with arrayDestroy()
+  */
+  WordIter wi = wordIterCreate (s,sep,0);
+  char *pos;
+
+  Texta a = textCreate (10);
+  while ((pos = wordNext (wi)) != NULL)
+    textAddInterned (pool,a,pos);
+  wordIterDestroy (wi);
+  return a;
+}
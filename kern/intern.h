@@ -0,0 +1,71 @@
+/*****************************************************************************
+* (c) Copyright 2012-2013 F.Hoffmann-La Roche AG                             *
+* Contact: bioinfoc@bioinfoc.ch, Detlef.Wolf@Roche.com.                      *
+*                                                                            *
+* This file is part of BIOINFO-C. BIOINFO-C is free software: you can        *
+* redistribute it and/or modify it under the terms of the GNU Lesser         *
+* General Public License as published by the Free Software Foundation,       *
+* either version 3 of the License, or (at your option) any later version.    *
+*                                                                            *
+* BIOINFO-C is distributed in the hope that it will be useful, but           *
+* WITHOUT ANY WARRANTY; without even the implied warranty of                 *
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU          *
+* Lesser General Public License for more details. You should have            *
+* received a copy of the GNU Lesser General Public License along with        *
+* BIOINFO-C. If not, see <http://www.gnu.org/licenses/>.                     *
+*****************************************************************************/
+/** @file intern.h
+    @brief Module for string interning: each distinct string is stored
+    once and represented by one canonical pointer.
+    Module prefix intern_
+*/
+#ifndef INTERN_H
+#define INTERN_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stddef.h>
+#include "arena.h"
+#include "ohtable.h"
+#include "format.h"
+
+/**
+   The InternPool object. The members of this struct are PRIVATE for the
+   intern module - DO NOT access from outside the intern module
+*/
+typedef struct _internPoolStruct_ {
+  Arena arena; //!< holds the strings
+  OhTable table; //!< the strings in 'arena'
+}*InternPool;
+
+extern InternPool intern_poolCreate (int sizeHint);
+extern void intern_poolDestroyFunc (InternPool this1); /* do not use this function */
+/**
+   Destroy the InternPool and all its strings; do not call
+   intern_poolDestroyFunc but only this macro
+*/
+#define intern_poolDestroy(this1) ((this1) ? intern_poolDestroyFunc(this1),this1=NULL,1:0)
+extern char *intern_string (InternPool this1,char *s);
+extern char *intern_find (InternPool this1,char *s);
+extern int intern_count (InternPool this1);
+extern size_t intern_bytesGet (InternPool this1);
+
+/* ------------------- Textas of interned strings ------------------------ */
+
+/**
+   Adds the interned version of 's' to Texta 't'; the counterpart of
+   textAdd(). The strings belong to 'pool': destroy a Texta filled this
+   way with arrayDestroy(), not textDestroy()
+*/
+#define textAddInterned(pool,t,s) (array((t),arrayMax(t),char*)=intern_string((pool),(s)))
+
+extern Texta textStrtokInterned (InternPool pool,char *s,char *sep);
+extern Texta textFieldtokInterned (InternPool pool,char *s,char *sep);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -26,6 +26,23 @@
 #include <string.h>
 #include <errno.h>
 #include PLABLA_INCLUDE_IO_UNISTD
+#ifdef PLABLA_HAVE_MMAP
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+#endif
+#if BIOS_HAVE_ZLIB
+#include <zlib.h>
+#endif
+#ifdef PLABLA_HAVE_PTHREAD
+#include <pthread.h>
+#endif
+#ifdef PLABLA_HAVE_POSIX_SPAWN
+#include <fcntl.h>
+#include <spawn.h>
+#include <sys/wait.h>
+extern char **environ;
+#endif
 
 #include "log.h"
 #include "format.h"
@@ -39,6 +56,679 @@ static void register_nextLine (LineStream this1,char *(*f)(LineStream this1)) {
   this1->nextLine_hook = f;
 }
 
+static LineStream lineStreamCreate (void) {
+  /**
+     Internally used to allocate a line stream with all members cleared
+  */
+  return (LineStream)hlr_calloc (1,sizeof (struct _lineStreamStruct_));
+}
+
+/// Initial size of the block buffer of file and pipe streams
+#define LS_BLOCKSIZE (128*1024)
+/// consumed parts of a mapped file are given back to the kernel in steps of this size
+#define LS_RELEASESTEP (4*1024*1024)
+
+static char *nextLinePipe (LineStream this1);
+static void recordDestroy (LineStream this1);
+static void sourceWarn (LineStream this1,char *format,...);
+
+static int readFd (LineStream this1,char *buf,int n) {
+  /**
+     Default source of the block reader: read(2) from the file
+     descriptor of the stream, restarted if interrupted by a signal
+     @param[in] this1 - line stream object
+     @param[in] buf - where to put the bytes
+     @param[in] n - maximum number of bytes to read
+     @return number of bytes read; 0 at end of input or on error
+  */
+  int got;
+
+  do
+    got = read (this1->fd,buf,n);
+  while (got < 0 && errno == EINTR);
+  if (got < 0) {
+    sourceWarn (this1,"read: %s",strerror (errno));
+    return 0;
+  }
+  return got;
+}
+
+static void blockInit (LineStream this1) {
+  /**
+     Prepares the block reader for the file or pipe in this1->fp.
+     The FILE is only used to open and close the stream,
+     all reading bypasses stdio.
+  */
+  this1->fd = fileno (this1->fp);
+  this1->fill_hook = readFd;
+  this1->blkSize = LS_BLOCKSIZE;
+  this1->blk = (char *)hlr_malloc (this1->blkSize + 1); // +1 for '\0'
+  this1->blkBeg = 0;
+  this1->blkEnd = 0;
+  this1->blkEof = 0;
+}
+
+static void blockFill (LineStream this1) {
+  /**
+     Moves the unconsumed rest of the block to its start, doubles the
+     block if the rest fills it completely (a very long line) and
+     appends as many bytes as the source delivers with one call.
+     Postcondition: this1->blkEof is 1 if the source is exhausted
+  */
+  int rest = this1->blkEnd - this1->blkBeg;
+  int n;
+
+  if (this1->blkBeg > 0) {
+    memmove (this1->blk,this1->blk + this1->blkBeg,rest);
+    this1->blkBeg = 0;
+    this1->blkEnd = rest;
+  }
+  if (rest == this1->blkSize) {
+    this1->blkSize *= 2;
+    this1->blk = (char *)hlr_realloc (this1->blk,this1->blkSize + 1);
+    if (this1->blk == NULL)
+      die ("ls_nextLine: no memory for a line of more than %d bytes",rest);
+  }
+  n = this1->fill_hook (this1,this1->blk + this1->blkEnd,
+                        this1->blkSize - this1->blkEnd);
+  if (n > 0)
+    this1->blkEnd += n;
+  else
+    this1->blkEof = 1;
+}
+
+static char *nextLineBlock (LineStream this1) {
+  /**
+     The block reader behind file and pipe streams: finds the end of
+     the next line in the block buffer with memchr(), refilling the
+     buffer from the source in large chunks as needed. The line is
+     terminated in place, a trailing \n or \r\n is removed.
+     @param[in] this1 - line stream object
+     @return the line (inside the block buffer, stable until the next call);
+             NULL if no further line was found
+  */
+  char *s;
+  char *nl;
+  int scanned = 0; // bytes of the current line already known to contain no \n
+  int len;
+
+  for (;;) {
+    s = this1->blk + this1->blkBeg;
+    len = this1->blkEnd - this1->blkBeg;
+    if ((nl = (char *)memchr (s + scanned,'\n',len - scanned)) != NULL) {
+      len = nl - s;
+      this1->blkBeg += len + 1;
+      break;
+    }
+    if (this1->blkEof) {
+      if (len == 0)
+        return NULL;
+      this1->blkBeg = this1->blkEnd; // last line without \n
+      break;
+    }
+    scanned = len;
+    blockFill (this1);
+  }
+  if (len && s[len-1] == '\r')
+    len--;
+  s[len] = '\0';
+  this1->spanLen = len;
+  this1->count++;
+  return s;
+}
+
+#if BIOS_HAVE_ZLIB
+/* ------------------ gzip and BGZF input ------------------------------ */
+
+/// Largest BGZF block, compressed and uncompressed
+#define BGZF_MAXBLOCK 65536
+/// BGZF blocks inflated per worker thread and batch
+#define BGZF_BLOCKSPERTHREAD 16
+/// Upper limit for the number of threads inflating BGZF blocks
+#define BGZF_MAXTHREADS 8
+
+/// One BGZF block of the current batch
+typedef struct {
+  unsigned char *cdata; //!< the complete compressed block, header included
+  int csize; //!< size of 'cdata'
+  char *out; //!< inflated data
+  int outLen; //!< number of bytes in 'out'
+  int err; //!< 1 if the block could not be inflated or failed the CRC check
+} BgzfBlock;
+
+/// Decompression state of a gzip LineStream
+typedef struct {
+  unsigned char *in; //!< compressed input
+  int inSize; //!< allocated size of 'in'
+  int inBeg; //!< first unconsumed byte in 'in'
+  int inEnd; //!< end of valid data in 'in'
+  int inEof; //!< 1 if the compressed file is read completely
+  int done; //!< 1 if no more data can be inflated
+  z_stream zs; //!< inflater for plain gzip (one or more members)
+  int memberEnd; //!< 1 if 'zs' has finished a gzip member
+  int nThreads; //!< number of BGZF worker threads; 0 for plain gzip
+  z_stream *zsw; //!< one raw inflater per worker thread
+  BgzfBlock *blocks; //!< the blocks of the current batch
+  int maxBlocks; //!< allocated number of blocks
+  int nBlocks; //!< number of blocks in the current batch
+  int cur; //!< block currently handed out
+  int curPos; //!< offset of the next byte to hand out in block 'cur'
+  int plainRest; //!< 1 if a plain gzip member follows the current batch
+} GzState;
+
+static int gzRead (LineStream this1,GzState *gz) {
+  /**
+     Moves the unconsumed compressed input to the start of the input
+     buffer and appends as many bytes as one read delivers
+     @return number of bytes read; 0 at end of file
+  */
+  int got;
+
+  if (gz->inBeg > 0) {
+    memmove (gz->in,gz->in + gz->inBeg,gz->inEnd - gz->inBeg);
+    gz->inEnd -= gz->inBeg;
+    gz->inBeg = 0;
+  }
+  if (gz->inEof || gz->inEnd == gz->inSize)
+    return 0;
+  if ((got = readFd (this1,(char *)gz->in + gz->inEnd,
+                     gz->inSize - gz->inEnd)) == 0)
+    gz->inEof = 1;
+  gz->inEnd += got;
+  return got;
+}
+
+static int gzFill (LineStream this1,char *buf,int n) {
+  /**
+     Source of the block reader for plain gzip files: inflates into
+     'buf' until at least one byte was produced. Concatenated gzip
+     members are inflated one after the other like gzip -d does.
+     @return number of bytes inflated; 0 at end of data
+  */
+  GzState *gz = (GzState *)this1->gz;
+  int ret;
+
+  if (gz->done)
+    return 0;
+  gz->zs.next_out = (Bytef *)buf;
+  gz->zs.avail_out = n;
+  while (gz->zs.avail_out == (uInt)n) {
+    if (gz->inBeg == gz->inEnd && gzRead (this1,gz) == 0) {
+      if (!gz->memberEnd)
+        sourceWarn (this1,"gzip: unexpected end of file");
+      gz->done = 1;
+      break;
+    }
+    if (gz->memberEnd) {
+      if (gz->in[gz->inBeg] != 0x1f) { // trailing garbage, ignored by gzip too
+        gz->done = 1;
+        break;
+      }
+      inflateReset (&gz->zs);
+      gz->memberEnd = 0;
+    }
+    gz->zs.next_in = gz->in + gz->inBeg;
+    gz->zs.avail_in = gz->inEnd - gz->inBeg;
+    ret = inflate (&gz->zs,Z_NO_FLUSH);
+    gz->inBeg = gz->inEnd - gz->zs.avail_in;
+    if (ret == Z_STREAM_END)
+      gz->memberEnd = 1;
+    else if (ret != Z_OK && ret != Z_BUF_ERROR) {
+      sourceWarn (this1,"gzip: %s",gz->zs.msg ? gz->zs.msg : "corrupt data");
+      gz->done = 1;
+      break;
+    }
+  }
+  return n - gz->zs.avail_out;
+}
+
+static int bgzfBlockSize (unsigned char *p,int avail) {
+  /**
+     @param[in] p - start of a gzip member
+     @param[in] avail - number of bytes available at 'p'
+     @return total size of the BGZF block starting at 'p';
+             0 if 'p' does not start with a BGZF header
+  */
+  if (avail < 18 || p[0] != 0x1f || p[1] != 0x8b || p[2] != 8 ||
+      (p[3] & 4) == 0 || p[12] != 'B' || p[13] != 'C' || p[14] != 2)
+    return 0;
+  return (p[16] | p[17] << 8) + 1;
+}
+
+static void bgzfInflateBlock (z_stream *zs,BgzfBlock *b) {
+  /**
+     Inflates one BGZF block and verifies its length and CRC
+  */
+  unsigned char *c = b->cdata;
+  int hdrLen = 12 + (c[10] | c[11] << 8);
+  unsigned char *t = c + b->csize - 8; // trailer: CRC32, ISIZE
+  unsigned long crc = t[0] | t[1] << 8 | t[2] << 16 | (unsigned long)t[3] << 24;
+  unsigned long isize = t[4] | t[5] << 8 | t[6] << 16 | (unsigned long)t[7] << 24;
+  int ret;
+
+  b->outLen = 0;
+  b->err = 1;
+  if (hdrLen + 8 > b->csize || isize > BGZF_MAXBLOCK)
+    return;
+  inflateReset (zs);
+  zs->next_in = c + hdrLen;
+  zs->avail_in = b->csize - hdrLen - 8;
+  zs->next_out = (Bytef *)b->out;
+  zs->avail_out = BGZF_MAXBLOCK;
+  ret = inflate (zs,Z_FINISH);
+  b->outLen = BGZF_MAXBLOCK - zs->avail_out;
+  b->err = ret != Z_STREAM_END || b->outLen != isize ||
+    crc32 (0L,(Bytef *)b->out,b->outLen) != crc;
+}
+
+/// Argument of bgzfWorker()
+typedef struct {
+  GzState *gz; //!< the stream's decompression state
+  int t; //!< number of the worker, 0..gz->nThreads-1
+} BgzfWork;
+
+static void *bgzfWorker (void *arg) {
+  /**
+     Inflates every nThreads'th block of the current batch
+  */
+  BgzfWork *w = (BgzfWork *)arg;
+  GzState *gz = w->gz;
+  int i;
+
+  for (i=w->t;i<gz->nBlocks;i+=gz->nThreads)
+    bgzfInflateBlock (&gz->zsw[w->t],&gz->blocks[i]);
+  return NULL;
+}
+
+static int bgzfBatch (LineStream this1,GzState *gz) {
+  /**
+     Reads the next batch of complete BGZF blocks and inflates them
+     in parallel; the calling thread acts as worker 0.
+     @return number of blocks in the batch; 0 at end of data
+  */
+  BgzfWork work[BGZF_MAXTHREADS];
+#ifdef PLABLA_HAVE_PTHREAD
+  pthread_t tid[BGZF_MAXTHREADS];
+#endif
+  int started[BGZF_MAXTHREADS];
+  int pos;
+  int size;
+  int avail;
+  int t;
+  int i;
+
+  while (gzRead (this1,gz) > 0) // fill the input buffer completely
+    ;
+  gz->nBlocks = 0;
+  pos = gz->inBeg;
+  while (gz->nBlocks < gz->maxBlocks && (avail = gz->inEnd - pos) > 0) {
+    if ((size = bgzfBlockSize (gz->in + pos,avail)) == 0 || size > avail) {
+      if (size == 0 && (avail >= 18 || gz->inEof) && avail >= 2 &&
+          gz->in[pos] == 0x1f && gz->in[pos+1] == 0x8b)
+        gz->plainRest = 1; // an ordinary gzip member: stream from here on
+      else if (size == 0 && (avail >= 18 || gz->inEof)) {
+        sourceWarn (this1,"gzip: corrupt BGZF block header");
+        gz->done = 1; // after handing out this batch
+      }
+      else if (gz->inEof) {
+        sourceWarn (this1,"gzip: unexpected end of file");
+        gz->done = 1;
+      }
+      break;
+    }
+    gz->blocks[gz->nBlocks].cdata = gz->in + pos;
+    gz->blocks[gz->nBlocks++].csize = size;
+    pos += size;
+  }
+  for (t=0;t<gz->nThreads;t++) {
+    work[t].gz = gz;
+    work[t].t = t;
+#ifdef PLABLA_HAVE_PTHREAD
+    started[t] = t > 0 && pthread_create (&tid[t],NULL,bgzfWorker,&work[t]) == 0;
+#else
+    started[t] = 0;
+#endif
+  }
+  bgzfWorker (&work[0]);
+  for (t=1;t<gz->nThreads;t++) {
+#ifdef PLABLA_HAVE_PTHREAD
+    if (started[t])
+      pthread_join (tid[t],NULL);
+    else // could not start a thread: do its share here
+#endif
+      bgzfWorker (&work[t]);
+  }
+  gz->inBeg = pos; // the blocks' input is no longer needed
+  for (i=0;i<gz->nBlocks;i++)
+    if (gz->blocks[i].err) {
+      sourceWarn (this1,"gzip: corrupt BGZF block");
+      gz->nBlocks = i; // hand out what was good
+      gz->done = 1;
+      gz->plainRest = 0;
+      break;
+    }
+  if (gz->nBlocks == 0 && !gz->plainRest)
+    gz->done = 1;
+  gz->cur = 0;
+  gz->curPos = 0;
+  return gz->nBlocks;
+}
+
+static int bgzfFill (LineStream this1,char *buf,int n) {
+  /**
+     Source of the block reader for BGZF files: hands out the inflated
+     blocks of the current batch, inflating the next batch when needed.
+     A BGZF file may be followed by ordinary gzip members (e.g. cat
+     a.bgz b.gz); from the first of them on gzFill() takes over.
+     @return number of bytes put into 'buf'; 0 at end of data
+  */
+  GzState *gz = (GzState *)this1->gz;
+  BgzfBlock *b;
+  int len;
+
+  for (;;) {
+    while (gz->cur == gz->nBlocks) {
+      if (gz->plainRest)
+        return gzFill (this1,buf,n);
+      if (gz->done || bgzfBatch (this1,gz) == 0 && !gz->plainRest)
+        return 0;
+    }
+    b = &gz->blocks[gz->cur];
+    len = MIN (n,b->outLen - gz->curPos);
+    memcpy (buf,b->out + gz->curPos,len);
+    gz->curPos += len;
+    if (gz->curPos == b->outLen) {
+      gz->cur++;
+      gz->curPos = 0;
+    }
+    if (len > 0) // skip empty blocks, e.g. the BGZF end-of-file marker
+      return len;
+  }
+}
+
+static int gzThreadCount (void) {
+  /**
+     @return number of threads to inflate BGZF files with;
+             0 means inflate serially
+  */
+#if defined(PLABLA_HAVE_PTHREAD) && defined(_SC_NPROCESSORS_ONLN)
+  long n = sysconf (_SC_NPROCESSORS_ONLN);
+  return n > 1 ? MIN (n,BGZF_MAXTHREADS) : 0;
+#else
+  return 0;
+#endif
+}
+
+static void gzInit (LineStream this1) {
+  /**
+     Switches a file stream whose block buffer holds the first bytes of
+     a gzip file to in-process decompression. The bytes already read
+     become the start of the compressed input.
+  */
+  GzState *gz = (GzState *)hlr_calloc (1,sizeof (GzState));
+  int i;
+
+  if (inflateInit2 (&gz->zs,15 + 16) != Z_OK) // gzip format only
+    die ("ls_createFromFile: inflateInit2 failed");
+  gz->nThreads = bgzfBlockSize ((unsigned char *)this1->blk,this1->blkEnd) ?
+    gzThreadCount () : 0;
+  if (gz->nThreads > 0) {
+    gz->maxBlocks = gz->nThreads * BGZF_BLOCKSPERTHREAD;
+    gz->blocks = (BgzfBlock *)hlr_calloc (gz->maxBlocks,sizeof (BgzfBlock));
+    gz->blocks[0].out = (char *)hlr_malloc (gz->maxBlocks * BGZF_MAXBLOCK);
+    for (i=1;i<gz->maxBlocks;i++)
+      gz->blocks[i].out = gz->blocks[0].out + i * BGZF_MAXBLOCK;
+    gz->zsw = (z_stream *)hlr_calloc (gz->nThreads,sizeof (z_stream));
+    for (i=0;i<gz->nThreads;i++)
+      if (inflateInit2 (&gz->zsw[i],-15) != Z_OK) // raw deflate
+        die ("ls_createFromFile: inflateInit2 failed");
+    gz->inSize = gz->maxBlocks * BGZF_MAXBLOCK;
+  }
+  else
+    gz->inSize = LS_BLOCKSIZE;
+  gz->inSize = MAX (gz->inSize,this1->blkEnd);
+  gz->in = (unsigned char *)hlr_malloc (gz->inSize);
+  memcpy (gz->in,this1->blk,this1->blkEnd);
+  gz->inEnd = this1->blkEnd;
+  gz->inEof = this1->blkEof;
+  this1->blkEnd = 0;
+  this1->blkEof = 0;
+  this1->gz = gz;
+  this1->fill_hook = gz->nThreads > 0 ? bgzfFill : gzFill;
+}
+
+static void gzDestroy (LineStream this1) {
+  /**
+     Releases the decompression state of a gzip stream
+  */
+  GzState *gz = (GzState *)this1->gz;
+  int i;
+
+  inflateEnd (&gz->zs);
+  if (gz->nThreads > 0) {
+    for (i=0;i<gz->nThreads;i++)
+      inflateEnd (&gz->zsw[i]);
+    hlr_free (gz->zsw);
+    hlr_free (gz->blocks[0].out);
+    hlr_free (gz->blocks);
+  }
+  hlr_free (gz->in);
+  hlr_free (gz);
+  this1->gz = NULL;
+}
+#endif
+
+static int isGzip (char *p,int avail) {
+  /**
+     @return 1 if 'p' starts with the gzip magic bytes, else 0
+  */
+  return avail >= 2 && (unsigned char)p[0] == 0x1f && (unsigned char)p[1] == 0x8b;
+}
+
+#ifdef PLABLA_HAVE_PTHREAD
+/* ------------------ read-ahead thread -------------------------------- */
+
+/// State of the read-ahead thread of a LineStream, see ls_setReadAhead()
+typedef struct {
+  pthread_t tid; //!< the producer thread
+  pthread_mutex_t mutex; //!< protects all members below
+  pthread_cond_t cond; //!< signalled whenever a buffer is filled or freed
+  int (*source)(LineStream,char *,int); //!< the block reader source being wrapped
+  int nBuffers; //!< number of buffers in the ring
+  int bufSize; //!< size of each buffer
+  char **buf; //!< the ring of buffers
+  int *len; //!< number of valid bytes in each buffer; 0 marks end of input
+  int head; //!< next buffer to be handed to the block reader
+  int tail; //!< next buffer to be filled by the producer
+  int filled; //!< number of filled buffers
+  int pos; //!< bytes of buffer 'head' already handed out
+  int stop; //!< 1 if the producer has to terminate
+  char err[256]; //!< first error of the source, not yet reported
+} ReadAhead;
+
+static void readAheadReport (ReadAhead *ra) {
+  /**
+     Reports an error kept by sourceWarn(); called by the consumer
+     with ra->mutex held
+  */
+  if (ra->err[0] != '\0') {
+    warnAdd ("ls_nextLine",ra->err);
+    ra->err[0] = '\0';
+  }
+}
+#endif
+
+static void sourceWarn (LineStream this1,char *format,...) {
+  /**
+     Reports an error of the source of the block reader with warnAdd().
+     In read-ahead mode the source runs in the producer thread, which
+     must not call warnAdd() (module log.c is not thread-safe): the
+     first message is kept until the consumer reports it
+  */
+  char msg[256];
+  va_list args;
+#ifdef PLABLA_HAVE_PTHREAD
+  ReadAhead *ra = (ReadAhead *)this1->ra;
+#endif
+
+  va_start (args,format);
+  vsnprintf (msg,sizeof (msg),format,args);
+  va_end (args);
+#ifdef PLABLA_HAVE_PTHREAD
+  if (ra != NULL) {
+    pthread_mutex_lock (&ra->mutex);
+    if (ra->err[0] == '\0')
+      strcpy (ra->err,msg);
+    pthread_mutex_unlock (&ra->mutex);
+    return;
+  }
+#endif
+  warnAdd ("ls_nextLine",msg);
+}
+
+#ifdef PLABLA_HAVE_PTHREAD
+
+static void *readAheadProducer (void *arg) {
+  /**
+     Body of the read-ahead thread: fills free buffers of the ring
+     from the wrapped source until the end of input or until asked
+     to stop. While it runs, only this thread touches the source.
+  */
+  LineStream this1 = (LineStream)arg;
+  ReadAhead *ra = (ReadAhead *)this1->ra;
+  int i;
+  int n;
+
+  pthread_mutex_lock (&ra->mutex);
+  for (;;) {
+    while (ra->filled == ra->nBuffers && !ra->stop)
+      pthread_cond_wait (&ra->cond,&ra->mutex);
+    if (ra->stop)
+      break;
+    i = ra->tail;
+    pthread_mutex_unlock (&ra->mutex);
+    n = ra->source (this1,ra->buf[i],ra->bufSize);
+    pthread_mutex_lock (&ra->mutex);
+    ra->len[i] = n;
+    ra->tail = (ra->tail + 1) % ra->nBuffers;
+    ra->filled++;
+    pthread_cond_broadcast (&ra->cond);
+    if (n == 0)
+      break;
+  }
+  pthread_mutex_unlock (&ra->mutex);
+  return NULL;
+}
+
+static int readAheadFill (LineStream this1,char *buf,int n) {
+  /**
+     Source of the block reader in read-ahead mode: copies from the
+     oldest filled buffer, waiting for the producer if none is ready
+     @return number of bytes put into 'buf'; 0 at end of input
+  */
+  ReadAhead *ra = (ReadAhead *)this1->ra;
+  int len;
+
+  pthread_mutex_lock (&ra->mutex);
+  while (ra->filled == 0)
+    pthread_cond_wait (&ra->cond,&ra->mutex);
+  readAheadReport (ra);
+  pthread_mutex_unlock (&ra->mutex);
+  // buffer 'head' is not touched by the producer while it is filled
+  len = MIN (n,ra->len[ra->head] - ra->pos);
+  if (len == 0) // end of input, stays there
+    return 0;
+  memcpy (buf,ra->buf[ra->head] + ra->pos,len);
+  ra->pos += len;
+  if (ra->pos == ra->len[ra->head]) {
+    pthread_mutex_lock (&ra->mutex);
+    ra->head = (ra->head + 1) % ra->nBuffers;
+    ra->filled--;
+    ra->pos = 0;
+    pthread_cond_broadcast (&ra->cond);
+    pthread_mutex_unlock (&ra->mutex);
+  }
+  return len;
+}
+
+static void readAheadFree (LineStream this1) {
+  /**
+     Releases the read-ahead state and gives the source back to
+     the block reader
+  */
+  ReadAhead *ra = (ReadAhead *)this1->ra;
+  int i;
+
+  pthread_mutex_destroy (&ra->mutex);
+  pthread_cond_destroy (&ra->cond);
+  this1->fill_hook = ra->source;
+  for (i=0;i<ra->nBuffers;i++)
+    hlr_free (ra->buf[i]);
+  hlr_free (ra->buf);
+  hlr_free (ra->len);
+  hlr_free (ra);
+  this1->ra = NULL;
+}
+#endif
+
+static void readAheadStop (LineStream this1) {
+  /**
+     Terminates the read-ahead thread, if any, and gives the source
+     back to the block reader; data read ahead is discarded
+  */
+#ifdef PLABLA_HAVE_PTHREAD
+  ReadAhead *ra = (ReadAhead *)this1->ra;
+
+  if (ra == NULL)
+    return;
+  pthread_mutex_lock (&ra->mutex);
+  ra->stop = 1;
+  pthread_cond_broadcast (&ra->cond);
+  pthread_mutex_unlock (&ra->mutex);
+  pthread_join (ra->tid,NULL);
+  readAheadReport (ra);
+  readAheadFree (this1);
+#endif
+}
+
+static void blockDrain (LineStream this1) {
+  /**
+     Reads and discards the rest of the input, so that the writer
+     of a pipe does not get a SIGPIPE
+  */
+  readAheadStop (this1);
+  while (readFd (this1,this1->blk,this1->blkSize) > 0)
+    ;
+}
+
+static void blockClose (LineStream this1) {
+  /**
+     Closes the file or pipe of a block reader stream and releases
+     the block buffer; for pipes the exit status is recorded
+  */
+  readAheadStop (this1);
+#ifdef PLABLA_HAVE_POSIX_SPAWN
+  if (this1->pid > 0) { // from ls_createFromArgv()
+    fclose (this1->fp);
+    while (waitpid (this1->pid,&this1->status,0) < 0 && errno == EINTR)
+      ;
+    this1->pid = 0;
+  }
+  else
+#endif
+  if (this1->nextLine_hook == nextLinePipe)
+    this1->status = PLABLA_PCLOSE (this1->fp);
+  else
+    fclose (this1->fp);
+  this1->fp = NULL;
+  this1->fd = -1;
+  hlr_free (this1->blk);
+#if BIOS_HAVE_ZLIB
+  if (this1->gz != NULL)
+    gzDestroy (this1);
+#endif
+}
+
 static char *nextLineFile (LineStream this1) {
   /**
      Returns the next line of a file and closes the file if
@@ -48,27 +738,22 @@ static char *nextLineFile (LineStream this1) {
      @return the line (memory managed by this routine);
              NULL if no further line was found
   */
-  int ll;
+  char *line;
 
   if (this1 == NULL)
     die ("nextLineFile: NULL LineStream");
-  if ((ll = getLine (this1->fp,&this1->line,&this1->lineLen)) == 0) {
-    fclose (this1->fp);
-    this1->fp = NULL;
-    hlr_free (this1->line);
-    return NULL;
-  }
-  if (ll > 1 && this1->line[ll-2] == '\r')
-    this1->line[ll-2] = '\0';
-  else if (ll > 0 && this1->line[ll-1] == '\n')
-    this1->line[ll-1] = '\0';
-  this1->count++;
-  return this1->line;
+  if ((line = nextLineBlock (this1)) == NULL)
+    blockClose (this1);
+  return line;
 }
 
 LineStream ls_createFromFile (char *fn) {
   /**
      Creates a line stream from a file.<br>
+     gzip compressed files (including BGZF) are recognized by their
+     first bytes and decompressed in-process if the library was built
+     with BIOS_HAVE_ZLIB; the blocks of BGZF files are inflated in
+     parallel on multi-core machines.<br>
      To learn details call warnReport() from module log.c
      @param[in] fn - file name ("-" means stdin)
      @return a line stream object;
@@ -78,10 +763,7 @@ LineStream ls_createFromFile (char *fn) {
 
   if (fn == NULL)
     die ("ls_createFromFile: no file name given");
-  this1 = (LineStream)hlr_malloc (sizeof (struct _lineStreamStruct_));
-  this1->line = NULL;
-  this1->count = 0;
-  this1->status = 0;
+  this1 = lineStreamCreate ();
   if (strcmp (fn,"-") == 0)
     this1->fp = stdin;
   else
@@ -95,8 +777,16 @@ LineStream ls_createFromFile (char *fn) {
     hlr_free (this1);
     return NULL;
   }
+  blockInit (this1);
   register_nextLine (this1,nextLineFile);
-  this1->buffer = NULL;
+#if BIOS_HAVE_ZLIB
+  if (!PLABLA_ISATTY (this1->fd)) { // do not wait for a user's input here
+    while (this1->blkEnd < 2 && !this1->blkEof)
+      blockFill (this1);
+    if (isGzip (this1->blk,this1->blkEnd))
+      gzInit (this1);
+  }
+#endif
   return this1;
 }
 
@@ -109,22 +799,13 @@ static char *nextLinePipe (LineStream this1) {
      @return the line (memory managed by this routine);
              NULL if no further line was found
   */
-  int ll;
+  char *line;
 
   if (this1 == NULL)
     die ("nextLinePipe: NULL LineStream");
-  if ((ll = getLine (this1->fp,&this1->line,&this1->lineLen)) == 0) {
-    this1->status = PLABLA_PCLOSE (this1->fp);
-    this1->fp = NULL;
-    hlr_free (this1->line);
-    return NULL;
-  }
-  if (ll > 1 && this1->line[ll-2] == '\r')
-    this1->line[ll-2] = '\0';
-  else if (ll > 0 && this1->line[ll-1] == '\n')
-    this1->line[ll-1] = '\0';
-  this1->count++;
-  return this1->line;
+  if ((line = nextLineBlock (this1)) == NULL)
+    blockClose (this1);
+  return line;
 }
 
 LineStream ls_createFromPipe (char *command) {
@@ -140,21 +821,102 @@ LineStream ls_createFromPipe (char *command) {
 
   if (command == NULL)
     die ("ls_createFromPipe: no command given");
-  this1 = (LineStream)hlr_malloc (sizeof (struct _lineStreamStruct_));
-  this1->line = NULL;
-  this1->count = 0;
+  this1 = lineStreamCreate ();
   this1->status = -2; // undetermined
   this1->fp = PLABLA_POPEN (command,"r");
   if (this1->fp == NULL) {
     warnAdd ("ls_createFromPipe",
              stringPrintBuf ("'%s': %s",command,strerror (errno)));
+    hlr_free (this1);
     return NULL;
   }
+  blockInit (this1);
   register_nextLine (this1,nextLinePipe);
-  this1->buffer = NULL;
   return this1;
 }
 
+/// Requested size of the pipe buffer of ls_createFromArgv() (if supported)
+#define LS_PIPESIZE (1024*1024)
+
+LineStream ls_createFromArgv (char *argv[]) {
+  /**
+     Creates a line stream from the standard output of a program,
+     which is started directly, without a shell, e.g.<br>
+     char *args[] = {"zcat","test.dat.gz",NULL};<br>
+     ls = ls_createFromArgv (args);<br>
+     Since no shell is involved, arguments need no quoting and
+     starting many short-lived commands is much cheaper than with
+     ls_createFromPipe(). Where supported, the pipe buffer is enlarged
+     to reduce context switches.<br>
+     The exit status is reported by ls_skipStatusGet() like for
+     ls_createFromPipe().<br>
+     Postcondition: warnCount(NULL,NULL) !=0 if problem occured.
+     @param[in] argv - the program (searched in PATH) and its arguments,
+                       terminated by NULL
+     @return a line stream object;
+             NULL if the program could not been started
+  */
+#ifdef PLABLA_HAVE_POSIX_SPAWN
+  LineStream this1;
+  posix_spawn_file_actions_t fa;
+  pid_t pid;
+  int fds[2];
+  int err;
+
+  if (argv == NULL || argv[0] == NULL)
+    die ("ls_createFromArgv: no program given");
+  if (pipe (fds) != 0) {
+    warnAdd ("ls_createFromArgv",
+             stringPrintBuf ("'%s': pipe: %s",argv[0],strerror (errno)));
+    return NULL;
+  }
+  // keep the pipe out of the program and of other children of this process
+  fcntl (fds[0],F_SETFD,FD_CLOEXEC);
+  fcntl (fds[1],F_SETFD,FD_CLOEXEC);
+#ifdef F_SETPIPE_SZ
+  fcntl (fds[0],F_SETPIPE_SZ,LS_PIPESIZE); // a failure does not matter
+#endif
+  posix_spawn_file_actions_init (&fa);
+  posix_spawn_file_actions_adddup2 (&fa,fds[1],1);
+  err = posix_spawnp (&pid,argv[0],&fa,NULL,argv,environ);
+  posix_spawn_file_actions_destroy (&fa);
+  PLABLA_CLOSE (fds[1]);
+  if (err != 0) {
+    warnAdd ("ls_createFromArgv",
+             stringPrintBuf ("'%s': %s",argv[0],strerror (err)));
+    PLABLA_CLOSE (fds[0]);
+    return NULL;
+  }
+  this1 = lineStreamCreate ();
+  this1->status = -2; // undetermined
+  this1->pid = pid;
+  this1->fp = fdopen (fds[0],"r");
+  blockInit (this1);
+  register_nextLine (this1,nextLinePipe);
+  return this1;
+#else
+  Stringa cmd = stringCreate (100);
+  LineStream this1;
+  char *cp;
+  int i;
+
+  if (argv == NULL || argv[0] == NULL)
+    die ("ls_createFromArgv: no program given");
+  for (i=0;argv[i]!=NULL;i++) { // quote each argument for the shell
+    stringCat (cmd,i ? " '" : "'");
+    for (cp=argv[i];*cp!='\0';cp++)
+      if (*cp == '\'')
+        stringCat (cmd,"'\\''");
+      else
+        stringCatChar (cmd,*cp);
+    stringCatChar (cmd,'\'');
+  }
+  this1 = ls_createFromPipe (string (cmd));
+  stringDestroy (cmd);
+  return this1;
+#endif
+}
+
 static char *nextLineBuffer (LineStream this1) {
   /**
      Returns the next line of a buffer. The line can be of any length and
@@ -175,7 +937,8 @@ static char *nextLineBuffer (LineStream this1) {
   }
   this1->count++;
   if (len && s[len-1] == '\r')
-    s[len-1] = '\0';
+    s[--len] = '\0';
+  this1->spanLen = len;
   return s;
 }
 
@@ -201,12 +964,220 @@ LineStream ls_createFromBuffer (char *buffer) {
   }
   else
     manySepsAreOne = 1; // immediately return NULL
-  this1 = (LineStream)hlr_malloc (sizeof (struct _lineStreamStruct_));
-  this1->count = 0;
-  this1->status = 0;
+  this1 = lineStreamCreate ();
   this1->wi = wordIterCreate (buffer,"\n",manySepsAreOne);
   register_nextLine (this1,nextLineBuffer);
-  this1->buffer = NULL;
+  return this1;
+}
+
+static void releaseMapped (char *beg,char *end) {
+  /**
+     Tells the kernel that the pages of a read-only file mapping
+     between beg and end are not needed anymore. Their contents stay
+     accessible: if touched again, they are read again from the file
+  */
+#ifdef PLABLA_HAVE_MMAP
+  static long pageSize = 0;
+  size_t a,b;
+
+  if (pageSize == 0)
+    pageSize = sysconf (_SC_PAGESIZE);
+  a = ((size_t)beg + pageSize - 1) & ~(size_t)(pageSize - 1);
+  b = (size_t)end & ~(size_t)(pageSize - 1);
+  if (a < b)
+    madvise ((void *)a,b - a,MADV_DONTNEED);
+#endif
+}
+
+static void releaseConsumed (LineStream this1) {
+  /**
+     Releases the pages of a mapped file before the current position
+     once LS_RELEASESTEP bytes have been consumed, so reading a large
+     file does not keep all of it in memory
+  */
+  if (this1->mapPos - this1->mapReleased < LS_RELEASESTEP)
+    return;
+  releaseMapped (this1->map + this1->mapReleased,this1->map + this1->mapPos);
+  this1->mapReleased = this1->mapPos;
+}
+
+static void unmapFile (LineStream this1) {
+  /**
+     Releases the mapping of a stream created by ls_createFromMmap()
+  */
+#ifdef PLABLA_HAVE_MMAP
+  if (this1->map != NULL)
+    munmap (this1->map,this1->mapLen);
+#endif
+  this1->map = NULL;
+  hlr_free (this1->line);
+}
+
+static char *nextSpanMmap (LineStream this1) {
+  /**
+     Returns the next line of a mapped file as a view into the mapping
+     and releases the mapping if no further line was found.
+     The line is NOT '\0'-terminated; its length is left in
+     this1->spanLen. A trailing \n or \r\n is not part of the line.
+     @param[in] this1 - line stream object
+     @return start of the line (inside the mapping);
+             NULL if no further line was found
+  */
+  char *s;
+  char *nl;
+  size_t rest;
+  int len;
+
+  if (this1 == NULL)
+    die ("nextSpanMmap: NULL LineStream");
+  if (this1->map == NULL)
+    return NULL;
+  if (this1->mapPos >= this1->mapLen) {
+    unmapFile (this1);
+    return NULL;
+  }
+  releaseConsumed (this1);
+  s = this1->map + this1->mapPos;
+  rest = this1->mapLen - this1->mapPos;
+  if ((nl = (char *)memchr (s,'\n',rest)) != NULL) {
+    len = nl - s;
+    this1->mapPos += len + 1;
+  }
+  else {
+    len = rest;
+    this1->mapPos = this1->mapLen;
+  }
+  if (len && s[len-1] == '\r')
+    len--;
+  this1->spanLen = len;
+  this1->count++;
+  return s;
+}
+
+static char *terminateSpan (LineStream this1,char *s,int len) {
+  /**
+     Makes a view returned by nextSpanMmap() a '\0'-terminated string.
+     The mapping is read-only, so the line is copied into this1->line;
+     writing into a private mapping would make the kernel copy every
+     page read, i.e. keep the whole file in memory.
+     @param[in] this1 - line stream object
+     @param[in] s - start of the line
+     @param[in] len - length of the line
+     @return the terminated line, stable until the next call
+  */
+  if (s == this1->line)
+    return s;
+  if (this1->lineLen < len + 1) {
+    hlr_free (this1->line);
+    this1->lineLen = len + 1;
+    this1->line = (char *)hlr_malloc (this1->lineLen);
+  }
+  memcpy (this1->line,s,len);
+  this1->line[len] = '\0';
+  return this1->line;
+}
+
+static char *nextLineMmap (LineStream this1) {
+  /**
+     Returns a copy of the next line of a mapped file, '\0'-terminated
+     @param[in] this1 - line stream object
+     @return the line (memory managed by this routine);
+             NULL if no further line was found
+  */
+  char *s = nextSpanMmap (this1);
+
+  if (s == NULL)
+    return NULL;
+  return terminateSpan (this1,s,this1->spanLen);
+}
+
+static int mapFile (char *fn,char *caller,char **mapP,size_t *lenP) {
+  /**
+     Maps a file read-only into memory
+     @param[in] fn - file name
+     @param[in] caller - name of the calling function for warnings
+     @param[out] *mapP - start of the mapping; NULL for an empty file
+     @param[out] *lenP - length of the file
+     @return 1 if mapped;
+             0 if the file should rather be read than mapped (stdin,
+               not a regular file, gzip compressed, no mmap available);
+             -1 if the file could not be opened or mapped (see warnReport())
+  */
+#ifdef PLABLA_HAVE_MMAP
+  struct stat st;
+  int fd;
+  void *map;
+
+  if (strEqual (fn,"-"))
+    return 0;
+  if ((fd = PLABLA_OPEN (fn,O_RDONLY)) < 0 || fstat (fd,&st) != 0) {
+    warnAdd (caller,stringPrintBuf ("'%s': %s",fn,strerror (errno)));
+    if (fd >= 0)
+      PLABLA_CLOSE (fd);
+    return -1;
+  }
+  if (!S_ISREG (st.st_mode)) {
+    PLABLA_CLOSE (fd);
+    return 0;
+  }
+  map = NULL;
+  if (st.st_size > 0) {
+    map = mmap (NULL,st.st_size,PROT_READ,MAP_PRIVATE,fd,0);
+    if (map == MAP_FAILED) {
+      warnAdd (caller,stringPrintBuf ("'%s': mmap: %s",fn,strerror (errno)));
+      PLABLA_CLOSE (fd);
+      return -1;
+    }
+    if (BIOS_HAVE_ZLIB && isGzip ((char *)map,st.st_size)) {
+      munmap (map,st.st_size); // mapping compressed data does not help
+      PLABLA_CLOSE (fd);
+      return 0;
+    }
+  }
+  PLABLA_CLOSE (fd); // the mapping stays valid
+  *mapP = (char *)map;
+  *lenP = st.st_size;
+  return 1;
+#else
+  return 0;
+#endif
+}
+
+LineStream ls_createFromMmap (char *fn) {
+  /**
+     Creates a line stream from a file by mapping the whole file
+     into memory. Lines are not copied by ls_nextSpan(), which returns
+     views into the read-only mapping; these stay valid until the end of
+     the stream is reached or the stream is destroyed. ls_nextLine()
+     copies each line into a buffer to '\0'-terminate it; that line
+     is stable until the next call, as for other streams.<br>
+     Pages already read are given back to the kernel as the stream
+     advances, so memory use does not grow with the size of the file.<br>
+     If 'fn' is not a regular file (e.g. "-" for stdin or a FIFO),
+     is compressed or the platform does not support mmap,
+     this is ls_createFromFile().<br>
+     To learn details call warnReport() from module log.c
+     @param[in] fn - file name
+     @return a line stream object;
+             NULL if file could not been opened or mapped
+  */
+  LineStream this1;
+  char *map;
+  size_t len;
+  int ret;
+
+  if (fn == NULL)
+    die ("ls_createFromMmap: no file name given");
+  if ((ret = mapFile (fn,"ls_createFromMmap",&map,&len)) <= 0)
+    return ret == 0 ? ls_createFromFile (fn) : NULL;
+#ifdef PLABLA_HAVE_MMAP
+  if (map != NULL)
+    madvise (map,len,MADV_SEQUENTIAL);
+#endif
+  this1 = lineStreamCreate ();
+  this1->map = map;
+  this1->mapLen = len;
+  register_nextLine (this1,nextLineMmap);
   return this1;
 }
 
@@ -218,26 +1189,25 @@ void ls_destroy_func (LineStream this1) {
      Do not call this function but use the macro ls_destroy.
      @param[in] this1 - a line stream object
   */
-  char line[1000];
-
   if (this1 == NULL)
     return;
   if (this1->nextLine_hook == nextLinePipe && this1->fp) {
-    while (fgets (line,sizeof (line),this1->fp)) {}
-    this1->status = PLABLA_PCLOSE (this1->fp);
-    hlr_free (this1->line);
+    blockDrain (this1);
+    blockClose (this1);
   }
   else if (this1->nextLine_hook == nextLineFile && this1->fp) {
     // if (this1->fp == stdin)
-    if (!PLABLA_ISATTY (fileno (this1->fp)))
-      while (fgets (line,sizeof (line),this1->fp))
-        ;
-    fclose (this1->fp);
-    hlr_free (this1->line);
+    if (!PLABLA_ISATTY (this1->fd))
+      blockDrain (this1);
+    blockClose (this1);
   }
   else if (this1->nextLine_hook == nextLineBuffer && this1->wi) {
     wordIterDestroy (this1->wi);
   }
+  else if (this1->nextLine_hook == nextLineMmap)
+    unmapFile (this1);
+  if (this1->rec != NULL)
+    recordDestroy (this1);
   stringDestroy (this1->buffer);
   hlr_free (this1);
 }
@@ -266,19 +1236,72 @@ char *ls_nextLine (LineStream this1) {
     else {
       // only get the next line if there we did not yet see the end of file
       line = this1->bufferLine ? this1->nextLine_hook (this1) : NULL;
-      if (line != NULL) {
+      if (line != NULL && this1->map != NULL)
+        this1->bufferLine = line; // already a copy in this1->line
+      else if (line != NULL) {
         stringCpy (this1->buffer,line);
         this1->bufferLine = string (this1->buffer);
       }
       else
         this1->bufferLine = NULL;
+      this1->bufferLen = line ? this1->spanLen : 0;
     }
+    // the pushed back line may have been returned by ls_nextSpan()
+    if (line != NULL && this1->map != NULL)
+      line = this1->bufferLine = terminateSpan (this1,line,this1->bufferLen);
   }
   else
     line = this1->nextLine_hook (this1);
   return line;
 }
 
+char *ls_nextSpan (LineStream this1,int *lenP) {
+  /**
+     Like ls_nextLine(), but also returns the length of the line.<br>
+     On a stream from ls_createFromMmap() this is the zero-copy way to
+     read: the line is a view into the mapped file and is NOT
+     '\0'-terminated; it must not be modified and stays valid until
+     the end of the stream is reached. On all other streams the line
+     happens to be terminated, but callers should not rely on it.<br>
+     Calls to ls_nextSpan() and ls_nextLine() may be mixed;
+     ls_bufferSet()/ls_back() work as for ls_nextLine().
+     @param[in] this1 - a line stream
+     @param[out] *lenP - length of the line (0 at end of stream)
+     @return start of the line if there is still a line, else NULL
+  */
+  char *line;
+
+  if (this1 == NULL)
+    die ("%s",warnCount (NULL,NULL) ? warnReport () :
+         "ls_nextSpan: invalid LineStream");
+  if (this1->buffer != NULL) {
+    if (this1->bufferBack > 0) {
+      this1->bufferBack = 0;
+      *lenP = this1->bufferLen;
+      return this1->bufferLine;
+    }
+    line = NULL;
+    if (this1->bufferLine != NULL)
+      line = this1->nextLine_hook == nextLineMmap ?
+        nextSpanMmap (this1) : this1->nextLine_hook (this1);
+    if (line != NULL && this1->map != NULL)
+      this1->bufferLine = line;
+    else if (line != NULL) {
+      stringNCpy (this1->buffer,line,this1->spanLen);
+      this1->bufferLine = string (this1->buffer);
+    }
+    else
+      this1->bufferLine = NULL;
+    this1->bufferLen = line ? this1->spanLen : 0;
+    *lenP = this1->bufferLen;
+    return this1->bufferLine;
+  }
+  line = this1->nextLine_hook == nextLineMmap ?
+    nextSpanMmap (this1) : this1->nextLine_hook (this1);
+  *lenP = line ? this1->spanLen : 0;
+  return line;
+}
+
 void ls_bufferSet (LineStream this1,int lineCnt) {
   /**
      Set how many lines the linestream should buffer.<br>
@@ -297,6 +1320,55 @@ void ls_bufferSet (LineStream this1,int lineCnt) {
   this1->bufferLine = ""; // dummy init, to kick off reading
 }
 
+void ls_setReadAhead (LineStream this1,int nBuffers,int bufSize) {
+  /**
+     Switch a line stream from a file or pipe to asynchronous mode:
+     a background thread reads (and decompresses) 'nBuffers' buffers
+     of 'bufSize' bytes ahead, while the caller processes lines.
+     This overlaps I/O wait, e.g. on network file systems, with the
+     work done per line. Lines are returned exactly as without
+     read-ahead.<br>
+     Streams over buffers or mapped files are not changed, nor is
+     anything done on platforms without threads. If the thread
+     cannot be started the stream stays synchronous (see warnReport()).<br>
+     Precondition: the stream is not at its end
+     @param[in] this1 - a line stream
+     @param[in] nBuffers - number of buffers, at least 2;
+                           0 or less means 3
+     @param[in] bufSize - size of each buffer in bytes;
+                          0 or less means 1 MB
+  */
+#ifdef PLABLA_HAVE_PTHREAD
+  ReadAhead *ra;
+  int i;
+
+  if (this1->nextLine_hook != nextLineFile &&
+      this1->nextLine_hook != nextLinePipe)
+    return;
+  if (this1->ra != NULL)
+    die ("ls_setReadAhead() more than once");
+  if (this1->fp == NULL)
+    die ("ls_setReadAhead() too late, stream is at its end");
+  ra = (ReadAhead *)hlr_calloc (1,sizeof (ReadAhead));
+  ra->nBuffers = nBuffers > 0 ? MAX (nBuffers,2) : 3;
+  ra->bufSize = bufSize > 0 ? MAX (bufSize,4096) : 1024 * 1024;
+  ra->buf = (char **)hlr_calloc (ra->nBuffers,sizeof (char *));
+  ra->len = (int *)hlr_calloc (ra->nBuffers,sizeof (int));
+  for (i=0;i<ra->nBuffers;i++)
+    ra->buf[i] = (char *)hlr_malloc (ra->bufSize);
+  ra->source = this1->fill_hook;
+  pthread_mutex_init (&ra->mutex,NULL);
+  pthread_cond_init (&ra->cond,NULL);
+  this1->ra = ra;
+  this1->fill_hook = readAheadFill;
+  if ((i = pthread_create (&ra->tid,NULL,readAheadProducer,this1)) != 0) {
+    warnAdd ("ls_setReadAhead",stringPrintBuf ("pthread_create: %s",
+                                               strerror (i)));
+    readAheadFree (this1);
+  }
+#endif
+}
+
 void ls_back (LineStream this1,int lineCnt) {
   /**
      Push back 'lineCnt' lines.<br>
@@ -342,17 +1414,17 @@ int ls_skipStatusGet (LineStream this1) {
       wordIterDestroy (this1->wi);
   }
   else if (this1->nextLine_hook == nextLineFile) {
-    if (this1->fp != NULL) {
-      fclose (this1->fp);
-      this1->fp = NULL;
-      hlr_free (this1->line);
-    }
+    if (this1->fp != NULL)
+      blockClose (this1);
   }
   else if (this1->nextLine_hook == nextLinePipe) {
-    if (this1->fp != NULL)
-      while (nextLinePipe(this1))
-        ;
+    if (this1->fp != NULL) {
+      blockDrain (this1);
+      blockClose (this1);
+    }
   }
+  else if (this1->nextLine_hook == nextLineMmap)
+    unmapFile (this1);
   return this1->status;
 }
 
@@ -399,6 +1471,518 @@ int ls_isEof (LineStream this1) {
   */
   if (this1->nextLine_hook == nextLineBuffer)
     return this1->wi == NULL ? 1 : 0;
+  else if (this1->nextLine_hook == nextLineMmap)
+    return this1->map == NULL ? 1 : 0;
   else
     return this1->fp == NULL ? 1 : 0;
 }
+
+/* ------------------ record mode ------------------------------------- */
+
+/// State of the record mode of a LineStream, see ls_recordSet()
+typedef struct {
+  char *startPrefix; //!< lines starting with this begin a record, or NULL
+  int startLen; //!< strlen(startPrefix)
+  char *endLine; //!< a line equal to this ends a record, or NULL
+  int endLen; //!< strlen(endLine)
+  LsRecordFunc isStart; //!< predicate for lines beginning a record, or NULL
+  LsRecordFunc isEnd; //!< predicate for lines ending a record, or NULL
+  Stringa rec; //!< the record returned (streams that are not mapped)
+  Stringa next; //!< first line of the next record if 'hasNext'
+  int hasNext; //!< 1 if the first line of the next record was read already
+  int atEnd; //!< 1 if the stream has been read completely
+} LsRecord;
+
+static int recordIsStart (LsRecord *r,char *line,int len) {
+  /**
+     @return 1 if 'line' (of length 'len', not necessarily terminated)
+             begins a record
+  */
+  if (r->isStart != NULL)
+    return r->isStart (line,len);
+  return r->startPrefix != NULL && len >= r->startLen &&
+    memcmp (line,r->startPrefix,r->startLen) == 0;
+}
+
+static int recordIsEnd (LsRecord *r,char *line,int len) {
+  /**
+     @return 1 if 'line' (of length 'len', not necessarily terminated)
+             ends a record
+  */
+  if (r->isEnd != NULL)
+    return r->isEnd (line,len);
+  return r->endLine != NULL && len == r->endLen &&
+    memcmp (line,r->endLine,len) == 0;
+}
+
+static LsRecord *recordCreate (LineStream this1) {
+  /**
+     Switches the line stream to record mode
+  */
+  LsRecord *r;
+
+  if (this1->rec != NULL)
+    die ("ls_recordSet() more than once");
+  r = (LsRecord *)hlr_calloc (1,sizeof (LsRecord));
+  r->rec = stringCreate (1000);
+  r->next = stringCreate (100);
+  this1->rec = r;
+  return r;
+}
+
+static void recordDestroy (LineStream this1) {
+  /**
+     Releases the record mode state
+  */
+  LsRecord *r = (LsRecord *)this1->rec;
+
+  hlr_free (r->startPrefix);
+  hlr_free (r->endLine);
+  stringDestroy (r->rec);
+  stringDestroy (r->next);
+  hlr_free (r);
+  this1->rec = NULL;
+}
+
+void ls_recordSet (LineStream this1,char *startPrefix,char *endLine) {
+  /**
+     Switch a line stream to record mode, where ls_nextRecord() returns
+     groups of lines. A record begins with a line starting with
+     'startPrefix' and/or ends with a line equal to 'endLine' (which is
+     part of the record), e.g.<br>
+     FASTA: ls_recordSet (ls,">",NULL);<br>
+     SD files: ls_recordSet (ls,NULL,"$$$$");<br>
+     EMBL, HMMER: ls_recordSet (ls,NULL,"//");<br>
+     Lines before the first start line form a record of their own.
+     @param[in] this1 - a line stream
+     @param[in] startPrefix - prefix of lines beginning a record; NULL if
+                              records are only delimited by 'endLine'
+     @param[in] endLine - line ending a record; NULL if records are only
+                          delimited by 'startPrefix'
+  */
+  LsRecord *r;
+
+  if (startPrefix == NULL && endLine == NULL)
+    die ("ls_recordSet: neither start nor end of record given");
+  r = recordCreate (this1);
+  if (startPrefix != NULL) {
+    r->startPrefix = hlr_strdup (startPrefix);
+    r->startLen = strlen (startPrefix);
+  }
+  if (endLine != NULL) {
+    r->endLine = hlr_strdup (endLine);
+    r->endLen = strlen (endLine);
+  }
+}
+
+void ls_recordFuncSet (LineStream this1,LsRecordFunc isStart,
+                       LsRecordFunc isEnd) {
+  /**
+     Like ls_recordSet(), but records are recognized by predicates:
+     isStart(line,len) returns 1 if the line begins a record,
+     isEnd(line,len) returns 1 if the line ends a record. Lines passed
+     to the predicates need not be '\0'-terminated.
+     @param[in] this1 - a line stream
+     @param[in] isStart - predicate for first lines of records or NULL
+     @param[in] isEnd - predicate for last lines of records or NULL
+  */
+  LsRecord *r;
+
+  if (isStart == NULL && isEnd == NULL)
+    die ("ls_recordFuncSet: neither start nor end of record given");
+  r = recordCreate (this1);
+  r->isStart = isStart;
+  r->isEnd = isEnd;
+}
+
+static char *nextRecordMmap (LineStream this1,LsRecord *r,int *lenP) {
+  /**
+     Returns the next record of a mapped file as one view into the
+     mapping: all its lines with their original line ends, except the
+     one behind the last line
+  */
+  char *beg;
+  char *end;
+  char *s;
+  char *nl;
+  size_t next;
+  int len;
+  int first = 1;
+
+  if (this1->map == NULL || this1->mapPos >= this1->mapLen) {
+    unmapFile (this1);
+    *lenP = 0;
+    return NULL;
+  }
+  releaseConsumed (this1);
+  beg = end = this1->map + this1->mapPos;
+  while (this1->mapPos < this1->mapLen) {
+    s = this1->map + this1->mapPos;
+    if ((nl = (char *)memchr (s,'\n',this1->mapLen - this1->mapPos)) != NULL) {
+      len = nl - s;
+      next = this1->mapPos + len + 1;
+    }
+    else {
+      len = this1->mapLen - this1->mapPos;
+      next = this1->mapLen;
+    }
+    if (len && s[len-1] == '\r')
+      len--;
+    if (!first && recordIsStart (r,s,len))
+      break; // stays for the next record
+    this1->mapPos = next;
+    this1->count++;
+    end = s + len;
+    first = 0;
+    if (recordIsEnd (r,s,len))
+      break;
+  }
+  *lenP = end - beg;
+  return beg;
+}
+
+char *ls_nextRecord (LineStream this1,int *lenP) {
+  /**
+     Returns the next record of a line stream in record mode.<br>
+     On streams from ls_createFromMmap() the record is a view into the
+     mapped file, i.e. no line is copied; it contains the original line
+     ends (\n or \r\n) between its lines, is NOT '\0'-terminated, must
+     not be modified and stays valid until the end of the stream is
+     reached. On all other streams the lines are joined with \n into a
+     '\0'-terminated buffer which is stable until the next call.<br>
+     Note: ls_back() does not apply to records; do not read lines with
+     ls_nextLine() from a stream after using ls_nextRecord().
+     @param[in] this1 - a line stream after ls_recordSet() or
+                        ls_recordFuncSet()
+     @param[out] *lenP - length of the record (0 at end of stream)
+     @return start of the record if there is still one, else NULL
+  */
+  LsRecord *r = (LsRecord *)this1->rec;
+  char *line;
+  int len;
+  int first = 1;
+
+  if (r == NULL)
+    die ("ls_nextRecord() without preceeding ls_recordSet()");
+  if (this1->nextLine_hook == nextLineMmap)
+    return nextRecordMmap (this1,r,lenP);
+  stringClear (r->rec);
+  for (;;) {
+    if (r->hasNext) {
+      line = string (r->next);
+      len = stringLen (r->next);
+      r->hasNext = 0;
+    }
+    else {
+      line = r->atEnd ? NULL : this1->nextLine_hook (this1);
+      if (line == NULL) {
+        r->atEnd = 1;
+        break;
+      }
+      len = this1->spanLen;
+      if (!first && recordIsStart (r,line,len)) {
+        stringNCpy (r->next,line,len);
+        r->hasNext = 1;
+        break;
+      }
+    }
+    if (!first)
+      stringCatChar (r->rec,'\n');
+    stringNCat (r->rec,line,len);
+    first = 0;
+    if (recordIsEnd (r,line,len))
+      break;
+  }
+  *lenP = first ? 0 : stringLen (r->rec);
+  return first ? NULL : string (r->rec);
+}
+
+/* ------------------ parallel processing of the lines of a file ------- */
+
+/// Largest number of bytes of a file handed to a thread at a time
+#define LS_PARCHUNK (16*1024*1024)
+/// Smallest number of bytes of a file handed to a thread at a time
+#define LS_PARCHUNK_MIN (64*1024)
+
+/// A range of whole lines of a file processed by ls_parallelForLines()
+typedef struct {
+  char *beg; //!< first byte of the range, start of a line
+  char *end; //!< byte behind the range, behind a \n or the end of the file
+  Stringa out; //!< output of the callback for this range, NULL if not merging
+  long lineCnt; //!< number of lines in the range
+  int done; //!< 1 if all lines of the range have been processed
+} LsChunk;
+
+/// State shared by the threads of ls_parallelForLines()
+typedef struct {
+  LsChunk *chunks; //!< the ranges in file order
+  int nChunks; //!< number of ranges
+  LsLineFunc callback; //!< called for each line
+  void *userdata; //!< passed to 'callback'
+  int merge; //!< 1 if the output is merged in file order
+  int window; //!< how many ranges may be processed ahead of the merge
+  int next; //!< next range to be processed
+  int merged; //!< number of ranges written by the merge
+#ifdef PLABLA_HAVE_PTHREAD
+  pthread_mutex_t mutex; //!< protects 'next', 'merged' and LsChunk.done
+  pthread_cond_t cond; //!< signalled when a range is processed or written
+#endif
+} LsParallel;
+
+/// Argument of parallelWorker()
+typedef struct {
+  LsParallel *par; //!< the shared state
+  int thread; //!< number of the thread, 0..nThreads-1
+  char *line; //!< copy of the current line (malloc'ed, not hlr_)
+  int lineSize; //!< allocated size of 'line'
+} LsWorker;
+
+static void processChunk (LsParallel *par,LsChunk *c,LsWorker *w) {
+  /**
+     Calls the callback for each line of range 'c'. Each line is
+     copied into the worker's buffer to '\0'-terminate it: writing
+     into the mapping would make the kernel copy every page, i.e.
+     keep the whole file in memory
+  */
+  char *s = c->beg;
+  char *nl;
+  char *next;
+  int len;
+
+  while (s < c->end) {
+    if ((nl = (char *)memchr (s,'\n',c->end - s)) != NULL) {
+      len = nl - s;
+      next = nl + 1;
+    }
+    else {
+      len = c->end - s;
+      next = c->end;
+    }
+    if (len && s[len-1] == '\r')
+      len--;
+    if (w->lineSize < len + 1) {
+      // plain realloc: hlr_ allocation counts are not thread-safe
+      w->lineSize = MAX (len + 1,2 * w->lineSize);
+      if ((w->line = (char *)realloc (w->line,w->lineSize)) == NULL)
+        die ("processChunk: out of memory");
+    }
+    memcpy (w->line,s,len);
+    w->line[len] = '\0';
+    par->callback (w->line,len,w->thread,c->out,par->userdata);
+    c->lineCnt++;
+    s = next;
+  }
+  releaseMapped (c->beg,c->end);
+}
+
+static void *parallelWorker (void *arg) {
+  /**
+     Processes ranges until none is left; when merging, a worker
+     does not get further ahead of the merge than par->window ranges
+  */
+  LsWorker *w = (LsWorker *)arg;
+  LsParallel *par = w->par;
+  int i;
+
+  for (;;) {
+#ifdef PLABLA_HAVE_PTHREAD
+    pthread_mutex_lock (&par->mutex);
+    while (par->merge && par->next < par->nChunks &&
+           par->next >= par->merged + par->window)
+      pthread_cond_wait (&par->cond,&par->mutex);
+#endif
+    i = par->next < par->nChunks ? par->next++ : -1;
+#ifdef PLABLA_HAVE_PTHREAD
+    pthread_mutex_unlock (&par->mutex);
+#endif
+    if (i < 0)
+      break;
+    processChunk (par,&par->chunks[i],w);
+#ifdef PLABLA_HAVE_PTHREAD
+    pthread_mutex_lock (&par->mutex);
+    par->chunks[i].done = 1;
+    pthread_cond_broadcast (&par->cond);
+    pthread_mutex_unlock (&par->mutex);
+#else
+    par->chunks[i].done = 1;
+#endif
+  }
+  return NULL;
+}
+
+static long serialForLines (char *fn,LsLineFunc callback,void *userdata,
+                            FILE *out) {
+  /**
+     ls_parallelForLines() for files that cannot be mapped:
+     all lines are processed by the calling thread
+  */
+  LineStream ls;
+  Stringa s = NULL;
+  char *line;
+  int len;
+  long lineCnt = 0;
+
+  if ((ls = ls_createFromFile (fn)) == NULL)
+    return -1;
+  if (out != NULL)
+    s = stringCreate (LS_BLOCKSIZE);
+  while ((line = ls_nextSpan (ls,&len)) != NULL) {
+    callback (line,len,0,s,userdata);
+    lineCnt++;
+    if (s != NULL && stringLen (s) >= LS_BLOCKSIZE) {
+      fwrite (string (s),1,stringLen (s),out);
+      stringClear (s);
+    }
+  }
+  if (s != NULL)
+    fwrite (string (s),1,stringLen (s),out);
+  stringDestroy (s);
+  ls_destroy (ls);
+  return lineCnt;
+}
+
+long ls_parallelForLines (char *fn,int nThreads,LsLineFunc callback,
+                          void *userdata,FILE *out) {
+  /**
+     Calls 'callback' for every line of file 'fn', using several threads.
+     The file is mapped into memory and split into ranges of whole lines,
+     which the threads process concurrently; within a range lines are
+     processed in file order.<br>
+     Lines are passed like ls_nextLine() returns them ('\0'-terminated,
+     without trailing \n or \r\n, may be modified but not kept).<br>
+     If 'out' is not NULL, the callback may append its output to the
+     Stringa it receives (e.g. with stringCat() or stringAppendf());
+     the outputs are written to 'out' in the order of the lines of the
+     file, as if the file had been processed sequentially.<br>
+     Note: the callback runs in several threads at the same time and
+     must therefore only change data it owns; 'thread' can be used to
+     index per-thread results (e.g. counts to be summed up afterwards).<br>
+     Files that cannot be mapped (stdin, pipes, gzip) are processed
+     sequentially by the calling thread, with 'thread' always 0.
+     @param[in] fn - file name ("-" means stdin)
+     @param[in] nThreads - number of threads; 0 or less means one
+                           thread per CPU
+     @param[in] callback - called as callback(line,lineLen,thread,o,userdata)
+                           where thread is 0..nThreads-1 and o is NULL
+                           if 'out' is NULL
+     @param[in] userdata - passed to 'callback'
+     @param[in] out - where the outputs are merged to; NULL for no output
+     @return number of lines processed;
+             -1 if the file could not be read (see warnReport())
+  */
+  LsParallel par;
+  Array chunks;
+  Array workers;
+  LsWorker *w;
+  LsChunk *c;
+  char *map;
+  size_t len;
+  size_t pos;
+  size_t end;
+  size_t chunkSize;
+  char *nl;
+  long lineCnt = 0;
+  int ret;
+  int i;
+#ifdef PLABLA_HAVE_PTHREAD
+  Array tids;
+  int *started;
+#endif
+
+  if (fn == NULL || callback == NULL)
+    die ("ls_parallelForLines: no file name or callback given");
+  if ((ret = mapFile (fn,"ls_parallelForLines",&map,&len)) <= 0)
+    return ret == 0 ? serialForLines (fn,callback,userdata,out) : -1;
+#if defined(PLABLA_HAVE_PTHREAD) && defined(_SC_NPROCESSORS_ONLN)
+  if (nThreads <= 0)
+    nThreads = sysconf (_SC_NPROCESSORS_ONLN);
+#else
+  nThreads = 1;
+#endif
+  nThreads = MAX (nThreads,1);
+  chunkSize = MAX (len / (nThreads * 4),LS_PARCHUNK_MIN);
+  chunkSize = MIN (chunkSize,LS_PARCHUNK);
+  chunks = arrayCreate (len / chunkSize + 1,LsChunk);
+  for (pos=0;pos<len;pos=end) {
+    end = pos + chunkSize;
+    if (end >= len)
+      end = len;
+    else
+      end = (nl = (char *)memchr (map + end,'\n',len - end)) != NULL ?
+        nl + 1 - map : len;
+    c = arrayp (chunks,arrayMax (chunks),LsChunk);
+    c->beg = map + pos;
+    c->end = map + end;
+    c->out = out != NULL ? stringCreate (1024) : NULL;
+    c->lineCnt = 0;
+    c->done = 0;
+  }
+  par.chunks = arrayMax (chunks) ? arrp (chunks,0,LsChunk) : NULL;
+  par.nChunks = arrayMax (chunks);
+  par.callback = callback;
+  par.userdata = userdata;
+  par.merge = out != NULL;
+  par.window = 2 * nThreads;
+  par.next = 0;
+  par.merged = 0;
+  workers = arrayCreate (nThreads,LsWorker);
+  for (i=0;i<nThreads;i++) {
+    w = arrayp (workers,i,LsWorker);
+    w->par = &par;
+    w->thread = i;
+    w->line = NULL;
+    w->lineSize = 0;
+  }
+#ifdef PLABLA_HAVE_PTHREAD
+  pthread_mutex_init (&par.mutex,NULL);
+  pthread_cond_init (&par.cond,NULL);
+  tids = arrayCreate (nThreads,pthread_t);
+  started = (int *)hlr_calloc (nThreads,sizeof (int));
+  for (i=0;i<nThreads;i++)
+    started[i] = pthread_create (arrayp (tids,i,pthread_t),NULL,
+                                 parallelWorker,arrp (workers,i,LsWorker)) == 0;
+  if (!started[0]) { // not even one thread: do all the work here
+    par.window = par.nChunks;
+    parallelWorker (arrp (workers,0,LsWorker));
+  }
+  if (out != NULL)
+    for (i=0;i<par.nChunks;i++) {
+      c = par.chunks + i;
+      pthread_mutex_lock (&par.mutex);
+      while (!c->done)
+        pthread_cond_wait (&par.cond,&par.mutex);
+      pthread_mutex_unlock (&par.mutex);
+      fwrite (string (c->out),1,stringLen (c->out),out);
+      stringDestroy (c->out);
+      pthread_mutex_lock (&par.mutex);
+      par.merged = i + 1;
+      pthread_cond_broadcast (&par.cond);
+      pthread_mutex_unlock (&par.mutex);
+    }
+  for (i=0;i<nThreads;i++)
+    if (started[i])
+      pthread_join (arru (tids,i,pthread_t),NULL);
+  hlr_free (started);
+  arrayDestroy (tids);
+  pthread_mutex_destroy (&par.mutex);
+  pthread_cond_destroy (&par.cond);
+#else
+  parallelWorker (arrp (workers,0,LsWorker));
+  if (out != NULL)
+    for (i=0;i<par.nChunks;i++) {
+      fwrite (string (par.chunks[i].out),1,stringLen (par.chunks[i].out),out);
+      stringDestroy (par.chunks[i].out);
+    }
+#endif
+  for (i=0;i<par.nChunks;i++)
+    lineCnt += par.chunks[i].lineCnt;
+  for (i=0;i<nThreads;i++)
+    free (arru (workers,i,LsWorker).line);
+  arrayDestroy (workers);
+  arrayDestroy (chunks);
+#ifdef PLABLA_HAVE_MMAP
+  if (map != NULL)
+    munmap (map,len);
+#endif
+  return lineCnt;
+}
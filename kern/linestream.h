@@ -26,6 +26,7 @@
 extern "C" {
 #endif
 
+#include <stddef.h>
 #include "format.h"
 
 /**
@@ -39,16 +40,48 @@ typedef struct _lineStreamStruct_ {
   WordIter wi; //!< the WordIter used if buffer is being read
   int count; //!< number of the current line
   int status; //!< exit status of popen()
+  int pid; //!< process id of the child of ls_createFromArgv(), else 0
   char *(*nextLine_hook)(struct _lineStreamStruct_ *); //!< pointer to appropriate nextLine function
   Stringa buffer; //!< NULL if not in buffered mode, else used used for remembering last line seen
   char *bufferLine; //!< pointer to 'buffer' or NULL if EOF
   int bufferBack; //!< 0=normal, 1=take next line from buffer
+  int bufferLen; //!< length of 'bufferLine'
+  int spanLen; //!< length of the line last returned by nextLine_hook
+  char *map; //!< start of the mapped file (ls_createFromMmap) or NULL
+  size_t mapLen; //!< number of bytes mapped
+  size_t mapPos; //!< offset of the first unread byte in 'map'
+  size_t mapReleased; //!< 'map' up to this offset was given back to the kernel
+  int fd; //!< file descriptor read by the block reader (files and pipes)
+  int (*fill_hook)(struct _lineStreamStruct_ *,char *,int); //!< source of the block reader
+  char *blk; //!< block buffer of the block reader
+  int blkSize; //!< allocated size of 'blk' (plus one byte for '\0')
+  int blkBeg; //!< offset of the first unconsumed byte in 'blk'
+  int blkEnd; //!< offset behind the last valid byte in 'blk'
+  int blkEof; //!< 1 if the source of the block reader is exhausted
+  void *gz; //!< decompression state if the file is gzip compressed, else NULL
+  void *ra; //!< read-ahead state (ls_setReadAhead()) or NULL
+  void *rec; //!< record mode state (ls_recordSet()) or NULL
 }*LineStream;
 
+/**
+   Signature of the function called for every line by ls_parallelForLines()
+*/
+typedef void (*LsLineFunc)(char *line,int lineLen,int thread,
+                           Stringa out,void *userdata);
+
+/**
+   Signature of the predicates recognizing the first or last line
+   of a record, see ls_recordFuncSet()
+*/
+typedef int (*LsRecordFunc)(char *line,int lineLen);
+
 extern LineStream ls_createFromFile (char *fn);
 extern LineStream ls_createFromPipe (char *command);
+extern LineStream ls_createFromArgv (char *argv[]);
 extern LineStream ls_createFromBuffer (char *buffer);
+extern LineStream ls_createFromMmap (char *fn);
 extern char *ls_nextLine (LineStream this1);
+extern char *ls_nextSpan (LineStream this1,int *lenP);
 extern void ls_destroy_func (LineStream this1); /* do not use this function */
 
 /**
@@ -58,10 +91,17 @@ extern void ls_destroy_func (LineStream this1); /* do not use this function */
 
 extern void ls_bufferSet (LineStream this1,int lineCnt);
 extern void ls_back (LineStream this1,int lineCnt);
+extern void ls_setReadAhead (LineStream this1,int nBuffers,int bufSize);
 extern int ls_lineCountGet (LineStream this1);
 extern int ls_skipStatusGet (LineStream this1);
 extern void ls_cat (LineStream this1,char *filename);
 extern int ls_isEof (LineStream this1);
+extern void ls_recordSet (LineStream this1,char *startPrefix,char *endLine);
+extern void ls_recordFuncSet (LineStream this1,LsRecordFunc isStart,
+                              LsRecordFunc isEnd);
+extern char *ls_nextRecord (LineStream this1,int *lenP);
+extern long ls_parallelForLines (char *fn,int nThreads,LsLineFunc callback,
+                                 void *userdata,FILE *out);
 
 #ifdef __cplusplus
 }
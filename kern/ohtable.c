@@ -0,0 +1,491 @@
+/*****************************************************************************
+* (c) Copyright 2012-2013 F.Hoffmann-La Roche AG                             *
+* Contact: bioinfoc@bioinfoc.ch, Detlef.Wolf@Roche.com.                      *
+*                                                                            *
+* This file is part of BIOINFO-C. BIOINFO-C is free software: you can        *
+* redistribute it and/or modify it under the terms of the GNU Lesser         *
+* General Public License as published by the Free Software Foundation,       *
+* either version 3 of the License, or (at your option) any later version.    *
+*                                                                            *
+* BIOINFO-C is distributed in the hope that it will be useful, but           *
+* WITHOUT ANY WARRANTY; without even the implied warranty of                 *
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU          *
+* Lesser General Public License for more details. You should have            *
+* received a copy of the GNU Lesser General Public License along with        *
+* BIOINFO-C. If not, see <http://www.gnu.org/licenses/>.                     *
+*****************************************************************************/
+/** @file ohtable.c
+    @brief Open addressing hash table; a drop-in alternative to HashTable
+    for large tables: values are stored in one flat array, found via
+    one control byte per slot, probed 16 at a time.
+    Module prefix oht_
+    <br>
+    The layout follows the "Swiss table" design: each slot has a control
+    byte which is either EMPTY, DELETED or holds 7 bits of the hash of
+    the value in the slot. A lookup compares the control bytes of a group
+    of 16 slots at once (with SSE2 if available) and calls the order
+    function only for slots whose 7 bits match. Groups are probed
+    quadratically; the first group containing an EMPTY slot ends a
+    lookup. The table grows when 7/8 of the slots are in use.
+    <br>
+    Usage, like HashTable:<br>
+    OhTable t = oht_tableCreate (-1,myHash,myOrder,myClean);<br>
+    oht_tableInsert (t,value,NULL);<br>
+    if (oht_tableFind (t,key,&found)) ...<br>
+    oht_tableDestroy (t);<br>
+    The hash function must return the same number for values considered
+    equal by the order function and should spread the input over all
+    32 bits.
+*/
+#include <string.h>
+#include <stdint.h>
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+#include "log.h"
+#include "hlrmisc.h"
+#include "ohtable.h"
+
+/// default number of slots
+#define OHT_DEFAULT_SIZE 4096
+
+/// number of control bytes probed at once
+#define OHT_GROUP 16
+
+/// control byte of a slot never used
+#define OHT_EMPTY 0x80
+
+/// control byte of a slot whose value was deleted
+#define OHT_DELETED 0xfe
+
+static void hashSplit (OhTable this1,void *value,int *pos,int *h2) {
+  /**
+     Hashes 'value' and derives the slot to start probing at and the 7 bits
+     kept in the control byte from independent parts of the result
+  */
+  uint64_t m = (uint64_t)this1->hashFunction (value) * 0x9e3779b97f4a7c15ULL;
+
+  *h2 = (int)(m >> 57);
+  *pos = (int)((uint32_t)(m >> 25) & (uint32_t)(this1->capacity - 1));
+}
+
+static unsigned int groupMatch (unsigned char *ctrl,int c) {
+  /**
+     @return bit mask of the bytes among ctrl[0..OHT_GROUP-1] equal to c
+  */
+#ifdef __SSE2__
+  __m128i g = _mm_loadu_si128 ((__m128i *)ctrl);
+  return (unsigned int)_mm_movemask_epi8 (_mm_cmpeq_epi8 (g,_mm_set1_epi8 ((char)c)));
+#else
+  unsigned int mask = 0;
+  int i;
+
+  for (i=0;i<OHT_GROUP;i++)
+    if (ctrl[i] == c)
+      mask |= 1u << i;
+  return mask;
+#endif
+}
+
+static unsigned int groupMatchFree (unsigned char *ctrl) {
+  /**
+     @return bit mask of the bytes among ctrl[0..OHT_GROUP-1] which are
+             EMPTY or DELETED, i.e. have the high bit set
+  */
+#ifdef __SSE2__
+  return (unsigned int)_mm_movemask_epi8 (_mm_loadu_si128 ((__m128i *)ctrl));
+#else
+  unsigned int mask = 0;
+  int i;
+
+  for (i=0;i<OHT_GROUP;i++)
+    if (ctrl[i] & 0x80)
+      mask |= 1u << i;
+  return mask;
+#endif
+}
+
+static int lowestBit (unsigned int mask) {
+  /**
+     @return index of the lowest bit set in mask, which is not 0
+  */
+#ifdef __GNUC__
+  return __builtin_ctz (mask);
+#else
+  int i = 0;
+
+  while ((mask & 1) == 0) {
+    mask >>= 1;
+    i++;
+  }
+  return i;
+#endif
+}
+
+static int highestBit (unsigned int mask) {
+  /**
+     @return index of the highest bit set in mask, which is not 0
+  */
+#ifdef __GNUC__
+  return 31 - __builtin_clz (mask);
+#else
+  int i = -1;
+
+  while (mask != 0) {
+    mask >>= 1;
+    i++;
+  }
+  return i;
+#endif
+}
+
+static void setCtrl (OhTable this1,int i,int c) {
+  /**
+     Set the control byte of slot i; the first OHT_GROUP-1 control bytes
+     are mirrored behind the last one so a group can be read at any
+     position without wrapping around
+  */
+  this1->ctrl[i] = (unsigned char)c;
+  if (i < OHT_GROUP - 1)
+    this1->ctrl[this1->capacity + i] = (unsigned char)c;
+}
+
+static void tableAlloc (OhTable this1,int capacity) {
+  /**
+     Allocate empty slots for 'capacity' values
+  */
+  this1->capacity = capacity;
+  this1->ctrl = (unsigned char *)hlr_malloc (capacity + OHT_GROUP - 1);
+  memset (this1->ctrl,OHT_EMPTY,capacity + OHT_GROUP - 1);
+  this1->slots = (void **)hlr_malloc (capacity * sizeof (void *));
+  this1->numElements = 0;
+  this1->numDeleted = 0;
+  this1->growthLeft = capacity - capacity / 8;
+}
+
+static int capacityFor (int n) {
+  /**
+     @return the smallest capacity holding n values without growing
+  */
+  int capacity = OHT_GROUP;
+
+  while (capacity - capacity / 8 < n) {
+    if (capacity > (1 << 29))
+      die ("oht: more than %d elements",capacity - capacity / 8);
+    capacity *= 2;
+  }
+  return capacity;
+}
+
+static int findFree (OhTable this1,int pos) {
+  /**
+     @return first EMPTY or DELETED slot in the probe sequence from pos
+  */
+  int mask = this1->capacity - 1;
+  int step = 0;
+  unsigned int m;
+
+  for (;;) {
+    if ((m = groupMatchFree (this1->ctrl + pos)) != 0)
+      return (pos + lowestBit (m)) & mask;
+    step += OHT_GROUP;
+    pos = (pos + step) & mask;
+  }
+}
+
+static void rehash (OhTable this1,int capacity) {
+  /**
+     Move all values into a table with 'capacity' slots, dropping the
+     slots marked deleted
+  */
+  unsigned char *oldCtrl = this1->ctrl;
+  void **oldSlots = this1->slots;
+  int oldCapacity = this1->capacity;
+  int i,pos,h2,n;
+
+  n = this1->numElements;
+  tableAlloc (this1,capacity);
+  for (i=0;i<oldCapacity;i++) {
+    if (oldCtrl[i] & 0x80)
+      continue;
+    hashSplit (this1,oldSlots[i],&pos,&h2);
+    pos = findFree (this1,pos);
+    setCtrl (this1,pos,h2);
+    this1->slots[pos] = oldSlots[i];
+  }
+  this1->numElements = n;
+  this1->growthLeft -= n;
+  hlr_free (oldCtrl);
+  hlr_free (oldSlots);
+}
+
+static int findSlot (OhTable this1,void *value,int pos,int h2) {
+  /**
+     @return slot holding a value equal to 'value', -1 if none
+  */
+  int mask = this1->capacity - 1;
+  int step = 0;
+  unsigned char *g;
+  unsigned int m;
+  int i;
+
+  for (;;) {
+    g = this1->ctrl + pos;
+    m = groupMatch (g,h2);
+    while (m != 0) {
+      i = (pos + lowestBit (m)) & mask;
+      if (this1->orderFunction (value,this1->slots[i]) == 0)
+        return i;
+      m &= m - 1;
+    }
+    if (groupMatch (g,OHT_EMPTY) != 0)
+      return -1;
+    step += OHT_GROUP;
+    pos = (pos + step) & mask;
+  }
+}
+
+OhTable oht_tableCreate (int sizeHint,
+                         unsigned int (*hashFunction)(void *),
+                         int (*orderFunction)(void *,void *),
+                         void (*cleanFunction)(void *)) {
+  /**
+     Creates an open addressing hash table. The table grows as needed,
+     sizeHint only saves rehashing.<br>
+     Postcondition: User is responsible to free the memory allocated
+     by calling the function oht_tableDestroy().
+     @param[in] sizeHint - expected number of elements,
+                           value of -1 assigns a default
+     @param[in] hashFunction - hash function of a value
+     @param[in] orderFunction - compare function of two values, as for
+                                hash_tableCreate(); only 0 (equal) matters
+     @param[in] cleanFunction - clean function to describe how memory
+                                allocated to each entry should be freed;
+                                NULL if the table does not own the values
+     @return new OhTable
+  */
+  OhTable newTable = (OhTable)hlr_calloc (1,sizeof (struct _OhTableStruct_));
+
+  if (hashFunction == NULL)
+    die ("Mandatory to supply hashFunction in oht_tableCreate() arguments");
+  if (orderFunction == NULL)
+    die ("Mandatory to supply orderFunction in oht_tableCreate() arguments");
+  newTable->hashFunction = hashFunction;
+  newTable->orderFunction = orderFunction;
+  newTable->cleanFunction = cleanFunction;
+  tableAlloc (newTable,capacityFor (sizeHint < 1 ? OHT_DEFAULT_SIZE : sizeHint));
+  return newTable;
+}
+
+void oht_tableDestroyFunc (OhTable this1) {
+  /**
+     Destroys the OhTable and, if a cleanFunction was given, all its values.<br>
+     Note: This function is only for internal use. Function oht_tableDestroy()
+           should be used instead from outside the package.
+     @param[in] this1 - OhTable that should be destroyed
+  */
+  int i;
+
+  if (this1->cleanFunction != NULL)
+    for (i=0;i<this1->capacity;i++)
+      if ((this1->ctrl[i] & 0x80) == 0)
+        this1->cleanFunction (this1->slots[i]);
+  hlr_free (this1->ctrl);
+  hlr_free (this1->slots);
+  hlr_free (this1);
+}
+
+void oht_tableReserve (OhTable this1,int n) {
+  /**
+     Make room for n elements in total, so that inserting them
+     does not need rehashing
+     @param[in] this1 - an OhTable
+     @param[in] n - number of elements
+  */
+  int capacity = capacityFor (n);
+
+  if (capacity > this1->capacity)
+    rehash (this1,capacity);
+}
+
+int oht_tableInsert (OhTable this1,void *valueInsert,
+                     void (*modifyDuplicate)(void *,void *)) {
+  /**
+     Inserts a new value in the OhTable.<br>
+     Postcondition: the table owns the value if a cleanFunction was given
+     @param[in] this1 - an OhTable
+     @param[in] valueInsert - a pointer to new value to insert
+     @param[in] modifyDuplicate - NULL or modifyFunc() called with the value
+                                  in the table and valueInsert when an equal
+                                  value is already in the table; valueInsert
+                                  is not stored then
+     @return 0 if value found, else 1 if sucessfully inserted
+  */
+  int pos,h2,i;
+
+  hashSplit (this1,valueInsert,&pos,&h2);
+  i = findSlot (this1,valueInsert,pos,h2);
+  if (i >= 0) {
+    if (modifyDuplicate != NULL)
+      modifyDuplicate (this1->slots[i],valueInsert);
+    return 0;
+  }
+  i = findFree (this1,pos);
+  if (this1->growthLeft == 0 && this1->ctrl[i] == OHT_EMPTY) {
+    // grow, unless dropping deleted slots makes enough room
+    rehash (this1,this1->numElements < this1->capacity / 2 ?
+            this1->capacity : this1->capacity * 2);
+    hashSplit (this1,valueInsert,&pos,&h2);
+    i = findFree (this1,pos);
+  }
+  if (this1->ctrl[i] == OHT_EMPTY)
+    this1->growthLeft--;
+  else
+    this1->numDeleted--;
+  setCtrl (this1,i,h2);
+  this1->slots[i] = valueInsert;
+  this1->numElements++;
+  return 1;
+}
+
+int oht_tableFind (OhTable this1,void *valueToFind,void **valueFound) {
+  /**
+     Finds the value equal to valueToFind in the OhTable.
+     @param[in] this1 - an OhTable
+     @param[in] valueToFind - a pointer to value to search for; it should
+                              at least have the parts used by the hash and
+                              order functions
+     @param[out] valueFound - if not NULL: the value found in the table
+     @return 0 if not found, else 1 if found
+  */
+  int pos,h2,i;
+
+  hashSplit (this1,valueToFind,&pos,&h2);
+  i = findSlot (this1,valueToFind,pos,h2);
+  if (i < 0)
+    return 0;
+  if (valueFound != NULL)
+    *valueFound = this1->slots[i];
+  return 1;
+}
+
+int oht_tableDelete (OhTable this1,void *valueToDelete) {
+  /**
+     Deletes the entry equal to valueToDelete from the OhTable, calling
+     the cleanFunction on it
+     @param[in] this1 - an OhTable
+     @param[in] valueToDelete - a pointer to value to delete
+     @return 0 if not found, else 1 if sucessfully deleted
+  */
+  int pos,h2,i;
+  unsigned int before,after;
+  void *value;
+
+  hashSplit (this1,valueToDelete,&pos,&h2);
+  i = findSlot (this1,valueToDelete,pos,h2);
+  if (i < 0)
+    return 0;
+  value = this1->slots[i];
+  this1->numElements--;
+  before = groupMatch (this1->ctrl + ((i - OHT_GROUP) & (this1->capacity - 1)),
+                       OHT_EMPTY);
+  after = groupMatch (this1->ctrl + i,OHT_EMPTY);
+  if (before != 0 && after != 0 &&
+      (OHT_GROUP - 1 - highestBit (before)) + lowestBit (after) < OHT_GROUP) {
+    /* no group containing slot i was ever full, so no lookup has
+       probed past it: the slot can become EMPTY again */
+    setCtrl (this1,i,OHT_EMPTY);
+    this1->growthLeft++;
+  }
+  else {
+    setCtrl (this1,i,OHT_DELETED);
+    this1->numDeleted++;
+  }
+  if (this1->cleanFunction != NULL)
+    this1->cleanFunction (value);
+  return 1;
+}
+
+void oht_tablePrintStats (OhTable this1,FILE *outFile) {
+  /**
+     Prints statistics about an OhTable: size, load and the mean number
+     of groups probed by a successful lookup
+     @param[in] this1 - an OhTable
+     @param[in] outFile - file stream where the statistics should be printed
+  */
+  int mask = this1->capacity - 1;
+  long int probes = 0;
+  int i,pos,h2,step;
+
+  for (i=0;i<this1->capacity;i++) {
+    if (this1->ctrl[i] & 0x80)
+      continue;
+    hashSplit (this1,this1->slots[i],&pos,&h2);
+    step = 0;
+    probes++;
+    while (((i - pos) & mask) >= OHT_GROUP) {
+      step += OHT_GROUP;
+      pos = (pos + step) & mask;
+      probes++;
+    }
+  }
+  fprintf (outFile,"Capacity:%d\tNum_Elem:%d\tDeleted:%d\tLoad:%.3f\t"
+           "Groups_per_lookup:%.3f\n",
+           this1->capacity,this1->numElements,this1->numDeleted,
+           (double)this1->numElements / this1->capacity,
+           this1->numElements ? (double)probes / this1->numElements : 0.0);
+}
+
+int oht_tableNumElem (OhTable this1) {
+  /**
+     Returns the number of elements in the table
+     @param[in] this1 - an OhTable
+     @return number of elements
+  */
+  return this1->numElements;
+}
+
+//----- Functions for the OhTable iterator
+
+OhIterator oht_itCreate (OhTable table) {
+  /**
+     Creates an iterator to access the elements of an OhTable in no
+     particular order; the table must not be modified while iterating.<br>
+     Postcondition: User is responsible to free the memory allocated
+                    by calling the function oht_itDestroy().
+     @param[in] table - an OhTable
+     @return new iterator
+  */
+  OhIterator newIterator = (OhIterator)hlr_malloc (sizeof (struct _OhIteratorStruct_));
+
+  newIterator->table = table;
+  newIterator->pos = 0;
+  return newIterator;
+}
+
+void oht_itDestroyFunc (OhIterator iterator) {
+  /**
+     Destroys the OhTable iterator.<br>
+     Note: This function is only for internal use. Function oht_itDestroy()
+           should be used instead from outside the package.
+     @param[in] iterator - an OhTable iterator
+  */
+  hlr_free (iterator);
+}
+
+void *oht_itNextValue (OhIterator iterator) {
+  /**
+     Returns the next value and increments the iterator
+     @param[in] iterator - an OhTable iterator
+     @return pointer to next value stored in the OhTable;
+             NULL if no next element is found
+  */
+  OhTable t = iterator->table;
+
+  while (iterator->pos < t->capacity) {
+    if ((t->ctrl[iterator->pos] & 0x80) == 0)
+      return t->slots[iterator->pos++];
+    iterator->pos++;
+  }
+  return NULL;
+}
@@ -0,0 +1,76 @@
+/*****************************************************************************
+* (c) Copyright 2012-2013 F.Hoffmann-La Roche AG                             *
+* Contact: bioinfoc@bioinfoc.ch, Detlef.Wolf@Roche.com.                      *
+*                                                                            *
+* This file is part of BIOINFO-C. BIOINFO-C is free software: you can        *
+* redistribute it and/or modify it under the terms of the GNU Lesser         *
+* General Public License as published by the Free Software Foundation,       *
+* either version 3 of the License, or (at your option) any later version.    *
+*                                                                            *
+* BIOINFO-C is distributed in the hope that it will be useful, but           *
+* WITHOUT ANY WARRANTY; without even the implied warranty of                 *
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU          *
+* Lesser General Public License for more details. You should have            *
+* received a copy of the GNU Lesser General Public License along with        *
+* BIOINFO-C. If not, see <http://www.gnu.org/licenses/>.                     *
+*****************************************************************************/
+/** @file ohtable.h
+    @brief Open addressing hash table; a drop-in alternative to HashTable
+    for large tables: values are stored in one flat array, found via
+    one control byte per slot, probed 16 at a time.
+    Module prefix oht_
+*/
+#ifndef OHTABLE_H
+#define OHTABLE_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdio.h>
+
+/// the OhTable object
+typedef struct _OhTableStruct_ {
+  unsigned char *ctrl; //!< control byte per slot: empty, deleted or 7 bits of the hash
+  void **slots; //!< the values
+  int capacity; //!< number of slots, a power of 2
+  int numElements; //!< number of elements
+  int numDeleted; //!< number of slots marked deleted
+  int growthLeft; //!< elements that can be inserted before rehashing
+  unsigned int (*hashFunction)(void *); //!< function to hash a value
+  int (*orderFunction)(void *,void *); //!< function returning 0 for equal values
+  void (*cleanFunction)(void *); //!< function to free a value, NULL ok
+}*OhTable;
+
+/// the OhIterator object
+typedef struct _OhIteratorStruct_ {
+  OhTable table; //!< the table to iterate over
+  int pos; //!< next slot to look at
+}*OhIterator;
+
+extern OhTable oht_tableCreate (int sizeHint,
+                                unsigned int (*hashFunction)(void *),
+                                int (*orderFunction)(void *,void *),
+                                void (*cleanFunction)(void *));
+extern void oht_tableDestroyFunc (OhTable this1);
+/// use this macro, do not use oht_tableDestroyFunc()
+#define oht_tableDestroy(x) ((x) ? oht_tableDestroyFunc(x),x=NULL,1:0)
+extern void oht_tableReserve (OhTable this1,int n);
+extern int oht_tableInsert (OhTable this1,void *valueInsert,
+                            void (*modifyDuplicate)(void *,void *));
+extern int oht_tableFind (OhTable this1,void *valueToFind,void **valueFound);
+extern int oht_tableDelete (OhTable this1,void *valueToDelete);
+extern void oht_tablePrintStats (OhTable this1,FILE *outFile);
+extern int oht_tableNumElem (OhTable this1);
+
+extern OhIterator oht_itCreate (OhTable table);
+extern void oht_itDestroyFunc (OhIterator iterator);
+/// use this macro, do not use oht_itDestroyFunc()
+#define oht_itDestroy(x) ((x) ? oht_itDestroyFunc(x),x=NULL,1 : 0)
+extern void *oht_itNextValue (OhIterator iterator);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
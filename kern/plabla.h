@@ -45,6 +45,10 @@ extern "C" {
 #define PLABLA_OPEN open
 #define PLABLA_CLOSE close
 #define PLABLA_ISATTY isatty
+/// mmap(2) and <sys/mman.h> are available
+#define PLABLA_HAVE_MMAP 1
+/// POSIX threads are available (link with -lpthread)
+#define PLABLA_HAVE_PTHREAD 1
 #endif
 
 #if BIOS_PLATFORM == BIOS_PLATFORM_IRIX
@@ -56,6 +60,8 @@ extern "C" {
 #endif
 
 #if (BIOS_PLATFORM == BIOS_PLATFORM_LINUX) || (BIOS_PLATFORM == BIOS_PLATFORM_APPLE)
+/// posix_spawn(3) and <spawn.h> are available
+#define PLABLA_HAVE_POSIX_SPAWN 1
 #define PLABLA_FLOCK_OPENFFLAG O_RDONLY
 #define PLABLA_FLOCK(fildes) flock(fildes,LOCK_EX)
 #define PLABLA_FLOCKNB(fildes) flock(fildes,LOCK_EX|LOCK_NB)
@@ -42,4 +42,10 @@
 // number of bits in a long integer variable; currently 32 and 64 are supported
 #define BIOS_BITS_PER_LONG 64
 
+// 1 if zlib is available (link with -lz): LineStreams then read gzip
+// compressed files directly; can be set on the compiler command line
+#ifndef BIOS_HAVE_ZLIB
+#define BIOS_HAVE_ZLIB 0
+#endif
+
 #endif
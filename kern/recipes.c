@@ -1272,7 +1272,7 @@ void rcp_svdcmp (float **a,int m,int n,float *w,float **v) {
   float c,f,g,h,s,x,y,z;
   int i,j,k,l;
   int its,flag;
-  int jj,nm;
+  int jj,nm = 0; // set before use, silences -Wmaybe-uninitialized
   float scale,anorm;
   float *rv1;
 
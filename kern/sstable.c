@@ -0,0 +1,471 @@
+/*****************************************************************************
+* (c) Copyright 2012-2013 F.Hoffmann-La Roche AG                             *
+* Contact: bioinfoc@bioinfoc.ch, Detlef.Wolf@Roche.com.                      *
+*                                                                            *
+* This file is part of BIOINFO-C. BIOINFO-C is free software: you can        *
+* redistribute it and/or modify it under the terms of the GNU Lesser         *
+* General Public License as published by the Free Software Foundation,       *
+* either version 3 of the License, or (at your option) any later version.    *
+*                                                                            *
+* BIOINFO-C is distributed in the hope that it will be useful, but           *
+* WITHOUT ANY WARRANTY; without even the implied warranty of                 *
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU          *
+* Lesser General Public License for more details. You should have            *
+* received a copy of the GNU Lesser General Public License along with        *
+* BIOINFO-C. If not, see <http://www.gnu.org/licenses/>.                     *
+*****************************************************************************/
+/** @file sstable.c
+    @brief Module for immutable dictionaries of strings on disk: a file
+    is written once from keys with fixed-width values and then mapped
+    into memory by any number of processes for fast lookups.
+    Module prefix sst_
+    <br>
+    Instead of rebuilding a large StringList or HashTable of identifiers
+    from text at every program start, write the table once:<br>
+    SstWriter w = sst_writerCreate ("probes.sst",sizeof (int));<br>
+    sst_writerAdd (w,"1007_s_at",&probeId); ...<br>
+    sst_writerClose (w);<br>
+    and open it in each program; opening costs no more than mapping the
+    file, the pages are shared by all processes using the table:<br>
+    SsTable t = sst_open ("probes.sst");<br>
+    int *ip = sst_get (t,"1007_s_at");<br>
+    sst_close (t);
+    <br>
+    File layout (all integers in the byte order of the writing machine,
+    sections aligned to 8 bytes):<br>
+    - header, see SstHeader<br>
+    - key offsets: for each key in strcmp() order the uint64 offset of
+      the key in the string section<br>
+    - values: valueSize bytes per key, in the order of the keys<br>
+    - hash slots: numSlots pairs of uint32, the upper 32 bits of the
+      hash_string() of a key and its number + 1; 0 marks an empty slot;
+      linear probing from slot (hash & (numSlots - 1))<br>
+    - strings: the zero-terminated keys in sorted order
+*/
+#include "plabla.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include PLABLA_INCLUDE_IO_UNISTD
+#ifdef PLABLA_HAVE_MMAP
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+#endif
+#include "log.h"
+#include "format.h"
+#include "hlrmisc.h"
+#include "rofutil.h"
+#include "hash.h"
+#include "sstable.h"
+
+/// identifies a table file
+#define SST_MAGIC "BIOSSST"
+/// written as is, to recognize files from machines with other byte order
+#define SST_BYTEORDER 0x01020304
+/// increase when the layout changes, including hash_string()
+#define SST_VERSION 1
+
+/// header of a table file
+typedef struct {
+  char magic[8]; //!< SST_MAGIC
+  uint32_t byteOrder; //!< SST_BYTEORDER
+  uint32_t version; //!< SST_VERSION
+  uint64_t numEntries; //!< number of keys
+  uint64_t valueSize; //!< number of bytes of each value
+  uint64_t numSlots; //!< number of hash slots, a power of 2
+  uint64_t offKeys; //!< file offset of the key offsets
+  uint64_t offValues; //!< file offset of the values
+  uint64_t offSlots; //!< file offset of the hash slots
+  uint64_t offStrings; //!< file offset of the strings
+  uint64_t fileSize; //!< length of the file
+}SstHeader;
+
+/// a key in an SstWriter
+typedef struct {
+  char *key; //!< the key, in the arena of the writer
+  long i; //!< number of the value in the writer
+}SstWriterEntry;
+
+static uint64_t align8 (uint64_t n) {
+  return (n + 7) & ~(uint64_t)7;
+}
+
+SstWriter sst_writerCreate (char *fileName,int valueSize) {
+  /**
+     Starts a new table file.<br>
+     Postcondition: add keys with sst_writerAdd(), then write the file
+     with sst_writerClose()
+     @param[in] fileName - name of the file to write
+     @param[in] valueSize - number of bytes of the value of each key;
+                            0 for a set of strings without values
+     @return the writer
+  */
+  SstWriter this1;
+
+  if (valueSize < 0)
+    die ("sst_writerCreate: negative value size %d",valueSize);
+  this1 = (SstWriter)hlr_malloc (sizeof (struct _sstWriterStruct_));
+  this1->fileName = hlr_strdup (fileName);
+  this1->valueSize = valueSize;
+  this1->arena = arena_create (0);
+  this1->entries = arrayCreate (1024,SstWriterEntry);
+  this1->values = valueSize > 0 ? uArrayCreate (1024,valueSize) : NULL;
+  return this1;
+}
+
+void sst_writerAdd (SstWriter this1,char *key,void *value) {
+  /**
+     Adds a key and its value; keys must be unique
+     @param[in] this1 - the writer
+     @param[in] key - the key, copied
+     @param[in] value - valueSize bytes, copied; NULL for zeros
+  */
+  SstWriterEntry *e = arrayp (this1->entries,arrayMax (this1->entries),
+                              SstWriterEntry);
+  e->key = arena_strdup (this1->arena,key);
+  e->i = arrayMax (this1->entries) - 1;
+  if (this1->values != NULL) {
+    char *v = (char *)uArray (this1->values,arrayMax (this1->values));
+    if (value != NULL)
+      memcpy (v,value,this1->valueSize);
+    else
+      memset (v,0,this1->valueSize);
+  }
+}
+
+static int sst_entryOrder (SstWriterEntry *e1,SstWriterEntry *e2) {
+  return strcmp (e1->key,e2->key);
+}
+
+static void sst_write (FILE *f,void *p,size_t n,char *fileName) {
+  if (n > 0 && fwrite (p,1,n,f) != n)
+    die ("sst_writerClose: %s: %s",fileName,strerror (errno));
+}
+
+long sst_writerCloseFunc (SstWriter this1) {
+  /**
+     Writes the table file and destroys the writer. Dies if a key was
+     added twice or the file cannot be written.<br>
+     Note: This function is only for internal use. Use the macro
+     sst_writerClose() instead.
+     @param[in] this1 - the writer
+     @return number of keys written
+  */
+  static char zeros[8];
+  SstHeader h;
+  FILE *f;
+  uint64_t n = arrayMax (this1->entries);
+  uint64_t i,off,slot,hv;
+  uint32_t *slots;
+  SstWriterEntry *e;
+
+  arraySort (this1->entries,(ARRAYORDERF)sst_entryOrder);
+  for (i=1;i<n;i++)
+    if (strEqual (arrp (this1->entries,i-1,SstWriterEntry)->key,
+                  arrp (this1->entries,i,SstWriterEntry)->key))
+      die ("sst_writerClose: %s: duplicate key '%s'",this1->fileName,
+           arrp (this1->entries,i,SstWriterEntry)->key);
+  if (n >= UINTGR4_MAX)
+    die ("sst_writerClose: %s: too many keys",this1->fileName);
+  memset (&h,0,sizeof (h));
+  memcpy (h.magic,SST_MAGIC,sizeof (SST_MAGIC));
+  h.byteOrder = SST_BYTEORDER;
+  h.version = SST_VERSION;
+  h.numEntries = n;
+  h.valueSize = this1->valueSize;
+  h.numSlots = 8;
+  while (h.numSlots < 2 * n) // load factor at most 1/2
+    h.numSlots *= 2;
+  h.offKeys = align8 (sizeof (h));
+  h.offValues = h.offKeys + n * sizeof (uint64_t);
+  h.offSlots = h.offValues + align8 (n * h.valueSize);
+  h.offStrings = h.offSlots + h.numSlots * 2 * sizeof (uint32_t);
+  h.fileSize = h.offStrings;
+  for (i=0;i<n;i++)
+    h.fileSize += strlen (arrp (this1->entries,i,SstWriterEntry)->key) + 1;
+
+  f = hlr_fopenWrite (this1->fileName);
+  sst_write (f,&h,sizeof (h),this1->fileName);
+  sst_write (f,zeros,h.offKeys - sizeof (h),this1->fileName);
+  off = 0;
+  for (i=0;i<n;i++) {
+    sst_write (f,&off,sizeof (off),this1->fileName);
+    off += strlen (arrp (this1->entries,i,SstWriterEntry)->key) + 1;
+  }
+  if (this1->values != NULL)
+    for (i=0;i<n;i++)
+      sst_write (f,uArray (this1->values,arrp (this1->entries,i,SstWriterEntry)->i),
+                 h.valueSize,this1->fileName);
+  sst_write (f,zeros,h.offSlots - h.offValues - n * h.valueSize,this1->fileName);
+  slots = (uint32_t *)hlr_calloc (h.numSlots * 2,sizeof (uint32_t));
+  for (i=0;i<n;i++) {
+    hv = hash_string (arrp (this1->entries,i,SstWriterEntry)->key);
+    slot = hv & (h.numSlots - 1);
+    while (slots[2*slot+1] != 0)
+      slot = (slot + 1) & (h.numSlots - 1);
+    slots[2*slot] = (uint32_t)(hv >> 32);
+    slots[2*slot+1] = (uint32_t)(i + 1);
+  }
+  sst_write (f,slots,h.numSlots * 2 * sizeof (uint32_t),this1->fileName);
+  hlr_free (slots);
+  for (i=0;i<n;i++) {
+    e = arrp (this1->entries,i,SstWriterEntry);
+    sst_write (f,e->key,strlen (e->key) + 1,this1->fileName);
+  }
+  if (fclose (f) != 0)
+    die ("sst_writerClose: %s: %s",this1->fileName,strerror (errno));
+
+  hlr_free (this1->fileName);
+  arena_destroy (this1->arena);
+  arrayDestroy (this1->entries);
+  arrayDestroy (this1->values);
+  hlr_free (this1);
+  return (long)n;
+}
+
+static int sst_load (char *fileName,char **mapP,size_t *lenP,int *isMappedP) {
+  /**
+     Maps a file read-only and shared into memory; if the platform
+     has no mmap, reads it
+     @return 1 if ok, 0 on error (see warnReport())
+  */
+#ifdef PLABLA_HAVE_MMAP
+  struct stat st;
+  int fd;
+  void *map;
+
+  if ((fd = PLABLA_OPEN (fileName,O_RDONLY)) < 0 || fstat (fd,&st) != 0) {
+    warnAdd ("sst_open",stringPrintBuf ("'%s': %s",fileName,strerror (errno)));
+    if (fd >= 0)
+      PLABLA_CLOSE (fd);
+    return 0;
+  }
+  if (st.st_size < sizeof (SstHeader)) {
+    warnAdd ("sst_open",stringPrintBuf ("'%s': not a table file",fileName));
+    PLABLA_CLOSE (fd);
+    return 0;
+  }
+  map = mmap (NULL,st.st_size,PROT_READ,MAP_SHARED,fd,0);
+  PLABLA_CLOSE (fd); // the mapping stays valid
+  if (map == MAP_FAILED) {
+    warnAdd ("sst_open",stringPrintBuf ("'%s': mmap: %s",fileName,strerror (errno)));
+    return 0;
+  }
+  *mapP = (char *)map;
+  *lenP = st.st_size;
+  *isMappedP = 1;
+  return 1;
+#else
+  FILE *f = fopen (fileName,"rb");
+  long len;
+
+  if (f == NULL || fseek (f,0,SEEK_END) != 0 || (len = ftell (f)) < 0) {
+    warnAdd ("sst_open",stringPrintBuf ("'%s': %s",fileName,strerror (errno)));
+    if (f != NULL)
+      fclose (f);
+    return 0;
+  }
+  *mapP = (char *)hlr_malloc (len > 0 ? len : 1);
+  rewind (f);
+  if (fread (*mapP,1,len,f) != len) {
+    warnAdd ("sst_open",stringPrintBuf ("'%s': read error",fileName));
+    hlr_free (*mapP);
+    fclose (f);
+    return 0;
+  }
+  fclose (f);
+  *lenP = len;
+  *isMappedP = 0;
+  return 1;
+#endif
+}
+
+static int sst_sectionOk (uint64_t off,uint64_t len,uint64_t fileSize) {
+  return off <= fileSize && len <= fileSize - off && off % 8 == 0;
+}
+
+SsTable sst_open (char *fileName) {
+  /**
+     Opens a table file written by sst_writerClose(). The file is
+     mapped, not read, so this is fast for any size and the memory is
+     shared with other processes using the same file.<br>
+     Only the header and the section bounds are checked here; key
+     numbers and key offsets are checked when a lookup uses them and
+     a bad one stops the program with die(). Values are not checked.<br>
+     To learn details of errors call warnReport() from module log.c
+     @param[in] fileName - name of the file
+     @return the table, close with sst_close();
+             NULL if the file could not be opened or is not a table file
+  */
+  SsTable this1;
+  SstHeader h;
+  char *map;
+  size_t len;
+  int isMapped;
+
+  if (!sst_load (fileName,&map,&len,&isMapped))
+    return NULL;
+  if (len >= sizeof (h))
+    memcpy (&h,map,sizeof (h));
+  if (len < sizeof (h) || memcmp (h.magic,SST_MAGIC,sizeof (SST_MAGIC)) != 0 ||
+      h.byteOrder != SST_BYTEORDER || h.version != SST_VERSION ||
+      h.fileSize != len || h.numEntries >= UINTGR4_MAX ||
+      h.valueSize > INTGR4_MAX ||
+      h.numSlots <= h.numEntries || h.numSlots > len || (h.numSlots & (h.numSlots - 1)) != 0 ||
+      !sst_sectionOk (h.offKeys,h.numEntries * sizeof (uint64_t),len) ||
+      !sst_sectionOk (h.offValues,h.numEntries * h.valueSize,len) ||
+      !sst_sectionOk (h.offSlots,h.numSlots * 2 * sizeof (uint32_t),len) ||
+      !sst_sectionOk (h.offStrings,len - h.offStrings,len) ||
+      (h.numEntries > 0 && map[len-1] != '\0')) {
+    warnAdd ("sst_open",stringPrintBuf ("'%s': not a table file or wrong version",
+                                        fileName));
+#ifdef PLABLA_HAVE_MMAP
+    munmap (map,len);
+#else
+    hlr_free (map);
+#endif
+    return NULL;
+  }
+  this1 = (SsTable)hlr_malloc (sizeof (struct _ssTableStruct_));
+  this1->map = map;
+  this1->len = len;
+  this1->isMapped = isMapped;
+  this1->numEntries = (long)h.numEntries;
+  this1->valueSize = (int)h.valueSize;
+  this1->slotMask = h.numSlots - 1;
+  this1->keyOffsets = (uint64_t *)(map + h.offKeys);
+  this1->values = map + h.offValues;
+  this1->slots = (uint32_t *)(map + h.offSlots);
+  this1->strings = map + h.offStrings;
+  this1->stringsLen = len - h.offStrings;
+  return this1;
+}
+
+void sst_closeFunc (SsTable this1) {
+  /**
+     Closes a table; pointers to its keys and values become invalid.<br>
+     Note: This function is only for internal use. Use the macro
+     sst_close() instead.
+     @param[in] this1 - the table
+  */
+#ifdef PLABLA_HAVE_MMAP
+  if (this1->isMapped)
+    munmap (this1->map,this1->len);
+  else
+#endif
+    hlr_free (this1->map);
+  hlr_free (this1);
+}
+
+static char *sst_keyAt (SsTable this1,uint64_t i) {
+  // returns key number i (0 <= i < numEntries), checking its offset
+  uint64_t off = this1->keyOffsets[i];
+
+  if (off >= this1->stringsLen)
+    die ("sst: corrupt table, offset %llu of key %llu out of range",
+         (unsigned long long)off,(unsigned long long)i);
+  return this1->strings + off;
+}
+
+long sst_find (SsTable this1,char *key) {
+  /**
+     Looks up a key by its hash, in O(1)
+     @param[in] this1 - the table
+     @param[in] key - the key to find
+     @return number of the key in sorted order (for sst_key() and
+             sst_value()); -1 if not found
+  */
+  uint64_t hv = hash_string (key);
+  uint32_t tag = (uint32_t)(hv >> 32);
+  uint64_t slot = hv & this1->slotMask;
+  uint64_t n;
+  uint32_t *s;
+
+  for (n=0;n<=this1->slotMask;n++) { // a corrupt table may have no empty slot
+    s = this1->slots + 2 * slot;
+    if (s[1] == 0)
+      return -1;
+    if (s[1] > this1->numEntries)
+      die ("sst: corrupt table, slot %llu holds key %lu of %ld",
+           (unsigned long long)slot,(unsigned long)s[1],this1->numEntries);
+    if (s[0] == tag && strcmp (sst_keyAt (this1,s[1]-1),key) == 0)
+      return (long)s[1] - 1;
+    slot = (slot + 1) & this1->slotMask;
+  }
+  return -1;
+}
+
+void *sst_get (SsTable this1,char *key) {
+  /**
+     Looks up the value of a key
+     @param[in] this1 - the table
+     @param[in] key - the key to find
+     @return pointer to the valueSize bytes of the value, read-only and
+             aligned to 8 bytes if valueSize is a multiple of 8;
+             NULL if the key is not in the table or the table has no
+             values
+  */
+  long i = sst_find (this1,key);
+  return i < 0 || this1->valueSize == 0 ? NULL : sst_value (this1,i);
+}
+
+long sst_lowerBound (SsTable this1,char *key) {
+  /**
+     Binary search for range and prefix queries, in O(log n)
+     @param[in] this1 - the table
+     @param[in] key - a string, need not be in the table
+     @return number of the first key not smaller than 'key' in strcmp()
+             order; sst_count() if all keys are smaller
+  */
+  long lo = 0,hi = this1->numEntries,mid;
+
+  while (lo < hi) {
+    mid = lo + (hi - lo) / 2;
+    if (strcmp (sst_keyAt (this1,mid),key) < 0)
+      lo = mid + 1;
+    else
+      hi = mid;
+  }
+  return lo;
+}
+
+long sst_count (SsTable this1) {
+  /**
+     @param[in] this1 - the table
+     @return number of keys
+  */
+  return this1->numEntries;
+}
+
+int sst_valueSize (SsTable this1) {
+  /**
+     @param[in] this1 - the table
+     @return number of bytes of each value
+  */
+  return this1->valueSize;
+}
+
+char *sst_key (SsTable this1,long i) {
+  /**
+     @param[in] this1 - the table
+     @param[in] i - 0 <= i < sst_count(); keys are in strcmp() order
+     @return key number i, read-only
+  */
+  if (i < 0 || i >= this1->numEntries)
+    die ("sst_key(%ld): out of range, sst_count()=%ld",i,this1->numEntries);
+  return sst_keyAt (this1,i);
+}
+
+void *sst_value (SsTable this1,long i) {
+  /**
+     @param[in] this1 - the table
+     @param[in] i - 0 <= i < sst_count()
+     @return the value of key number i, read-only
+  */
+  if (i < 0 || i >= this1->numEntries)
+    die ("sst_value(%ld): out of range, sst_count()=%ld",i,this1->numEntries);
+  return this1->values + (size_t)i * this1->valueSize;
+}
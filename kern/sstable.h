@@ -0,0 +1,89 @@
+/*****************************************************************************
+* (c) Copyright 2012-2013 F.Hoffmann-La Roche AG                             *
+* Contact: bioinfoc@bioinfoc.ch, Detlef.Wolf@Roche.com.                      *
+*                                                                            *
+* This file is part of BIOINFO-C. BIOINFO-C is free software: you can        *
+* redistribute it and/or modify it under the terms of the GNU Lesser         *
+* General Public License as published by the Free Software Foundation,       *
+* either version 3 of the License, or (at your option) any later version.    *
+*                                                                            *
+* BIOINFO-C is distributed in the hope that it will be useful, but           *
+* WITHOUT ANY WARRANTY; without even the implied warranty of                 *
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU          *
+* Lesser General Public License for more details. You should have            *
+* received a copy of the GNU Lesser General Public License along with        *
+* BIOINFO-C. If not, see <http://www.gnu.org/licenses/>.                     *
+*****************************************************************************/
+/** @file sstable.h
+    @brief Module for immutable dictionaries of strings on disk: a file
+    is written once from keys with fixed-width values and then mapped
+    into memory by any number of processes for fast lookups.
+    Module prefix sst_
+*/
+#ifndef SSTABLE_H
+#define SSTABLE_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+#include <stddef.h>
+#include "array.h"
+#include "arena.h"
+
+/**
+   The SstWriter object collecting keys and values before they are
+   written. The members of this struct are PRIVATE for the sstable
+   module - DO NOT access from outside the sstable module
+*/
+typedef struct _sstWriterStruct_ {
+  char *fileName; //!< name of the file to write
+  int valueSize; //!< number of bytes of each value
+  Arena arena; //!< holds the keys
+  Array entries; //!< of SstWriterEntry, a key and its order of addition
+  Array values; //!< values in order of addition; NULL if valueSize is 0
+}*SstWriter;
+
+/**
+   The SsTable object, an opened table file. The members of this struct
+   are PRIVATE for the sstable module - DO NOT access from outside the
+   sstable module
+*/
+typedef struct _ssTableStruct_ {
+  char *map; //!< contents of the file
+  size_t len; //!< length of the file
+  int isMapped; //!< 1 if 'map' is a memory mapping, 0 if read into memory
+  long numEntries; //!< number of keys
+  int valueSize; //!< number of bytes of each value
+  uint64_t slotMask; //!< number of hash slots - 1
+  uint64_t *keyOffsets; //!< offsets of the sorted keys in 'strings'
+  char *values; //!< values in the order of the keys
+  uint32_t *slots; //!< hash slots: pairs of hash tag, key number + 1
+  char *strings; //!< the keys, zero-terminated
+  uint64_t stringsLen; //!< number of bytes of 'strings'
+}*SsTable;
+
+extern SstWriter sst_writerCreate (char *fileName,int valueSize);
+extern void sst_writerAdd (SstWriter this1,char *key,void *value);
+extern long sst_writerCloseFunc (SstWriter this1); /* do not use this function */
+/// write the file and destroy the writer; use this macro, not sst_writerCloseFunc()
+#define sst_writerClose(this1) (sst_writerCloseFunc(this1),this1=NULL)
+
+extern SsTable sst_open (char *fileName);
+extern void sst_closeFunc (SsTable this1); /* do not use this function */
+/// close the table; use this macro, not sst_closeFunc()
+#define sst_close(this1) ((this1) ? sst_closeFunc(this1),this1=NULL,1:0)
+extern long sst_find (SsTable this1,char *key);
+extern void *sst_get (SsTable this1,char *key);
+extern long sst_lowerBound (SsTable this1,char *key);
+extern long sst_count (SsTable this1);
+extern int sst_valueSize (SsTable this1);
+extern char *sst_key (SsTable this1,long i);
+extern void *sst_value (SsTable this1,long i);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -53,8 +53,16 @@
    Chapman&Hall 1993
 */
 
+#include "plabla.h"
+
 #include <unistd.h>
 #include <math.h>
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+#ifdef PLABLA_HAVE_PTHREAD
+#include <pthread.h>
+#endif
 #include "log.h"
 #include "array.h"
 #include "hlrmisc.h"
@@ -64,9 +72,7 @@
 #include "statistics.h"
 
 static void sortAscending (double x[],int num) {
-  if (num > 1)
-    qsort (x,num,sizeof (double),
-           (int (*)(const void *,const void *))arrayDoublecmp);
+  arraySortDoubles (x,num);
 }
 
 void stat_pca (int nObs,int nVar,double **data,
@@ -194,20 +200,25 @@ double stat_median (double x[],int num) {
     return x[n2];
 }
 
-static double mq_sub (double x[],int n,double m) {
+static double mq_interpolate (double x0,double x1,double m) {
+  // x0 and x1 are neighbors in sorted order, x1 is not used if m is 0
   if (m == 0.0)
-    return x[n];
+    return x0;
   else if (m == 0.25)
-    return 0.75 * x[n] + 0.25 * x[n+1];
+    return 0.75 * x0 + 0.25 * x1;
   else if (m == 0.5)
-    return 0.5 * x[n] + 0.5 * x[n+1];
+    return 0.5 * x0 + 0.5 * x1;
   else if (m == 0.75)
-    return 0.25 * x[n] + 0.75 * x[n+1];
+    return 0.25 * x0 + 0.75 * x1;
   else
     die ("double mq_sub: illegal fraction %f",m);
   return 0.0; // to keep compiler happy
 }
 
+static double mq_sub (double x[],int n,double m) {
+  return mq_interpolate (x[n],m == 0.0 ? 0.0 : x[n+1],m);
+}
+
 double stat_median_quart (double x[],int num,double *q25,double *q75) {
   /**
      Calculate median and both quartiles
@@ -238,6 +249,9 @@ double stat_median_quart (double x[],int num,double *q25,double *q75) {
   return mq_sub (x,n,m);
 }
 
+static void orderStatsInPlace (double a[],int num,int ranks[],int numRanks,
+                               double values[]);
+
 double stat_median_abs_dev (double x[], int num) {
   /**
      Calcuates the median of the deviation from the median
@@ -247,16 +261,251 @@ double stat_median_abs_dev (double x[], int num) {
   */
   int i;
   double median;
-  double res = 0;
   double *dev;
+  int ranks[2];
+  double v[2];
 
-  dev = (double *)malloc (num * sizeof (double));
+  dev = (double *)hlr_malloc (num * sizeof (double));
   median = stat_median (x,num);
   for (i=0;i<num;i++)
     dev[i] = fabs (x[i] - median);
-  res = stat_median (dev, num);
+  ranks[0] = (num - 1) / 2;
+  ranks[1] = num / 2;
+  orderStatsInPlace (dev,num,ranks,2,v); // dev is ours to rearrange
   hlr_free (dev);
-  return res;
+  return ranks[0] == ranks[1] ? v[1] : 0.5 * (v[0] + v[1]);
+}
+
+/* ---- order statistics by selection: O(n), the input is not changed ---- */
+
+static void selectRanks (double *a,int lo,int hi,int *k,int nk,int depth) {
+  /**
+     Rearranges a[lo..hi] such that a[k[i]] for i=0..nk-1 holds the value
+     it would have if a[lo..hi] were sorted (quickselect for several
+     ranks at once; after 'depth' rounds the rest is sorted, so the
+     worst case is O(n log n) instead of O(n^2))
+     @param[in] k - ranks, ascending, all in lo..hi
+  */
+  double pivot,t,x0,x1,x2;
+  int i,j,nl,nr;
+
+  while (nk > 0) {
+    if (hi - lo < 16) {
+      for (i=lo+1;i<=hi;i++) {
+        t = a[i];
+        for (j=i;j>lo && a[j-1]>t;j--)
+          a[j] = a[j-1];
+        a[j] = t;
+      }
+      return;
+    }
+    if (depth-- == 0) {
+      arraySortDoubles (a + lo,hi - lo + 1);
+      return;
+    }
+    x0 = a[lo];
+    x1 = a[lo + (hi - lo) / 2];
+    x2 = a[hi];
+    if (x0 > x1) {
+      t = x0;
+      x0 = x1;
+      x1 = t;
+    }
+    pivot = x2 < x0 ? x0 : x2 > x1 ? x1 : x2;
+    i = lo;
+    j = hi;
+    while (i <= j) {
+      while (a[i] < pivot)
+        i++;
+      while (a[j] > pivot)
+        j--;
+      if (i <= j) {
+        t = a[i];
+        a[i++] = a[j];
+        a[j--] = t;
+      }
+    }
+    // now a[lo..j] <= pivot, a[j+1..i-1] == pivot, a[i..hi] >= pivot
+    for (nl=0;nl<nk && k[nl]<=j;nl++);
+    for (nr=nl;nr<nk && k[nr]<i;nr++);
+    selectRanks (a,lo,j,k,nl,depth);
+    k += nr;
+    nk -= nr;
+    lo = i;
+  }
+}
+
+static void orderStatsInPlace (double a[],int num,int ranks[],int numRanks,
+                               double values[]) {
+  // stat_orderStats() on a[], which is rearranged
+  int kBuf[16];
+  int *k;
+  int i,j,t,depth;
+
+  k = numRanks <= 16 ? kBuf : (int *)hlr_malloc (numRanks * sizeof (int));
+  for (i=0;i<numRanks;i++) {
+    if (ranks[i] < 0 || ranks[i] >= num)
+      die ("stat_orderStats: rank %d out of range 0..%d",ranks[i],num-1);
+    t = ranks[i];
+    for (j=i;j>0 && k[j-1]>t;j--)
+      k[j] = k[j-1];
+    k[j] = t;
+  }
+  depth = 0;
+  for (i=num;i>1;i/=2)
+    depth += 2;
+  selectRanks (a,0,num-1,k,numRanks,depth);
+  for (i=0;i<numRanks;i++)
+    values[i] = a[ranks[i]];
+  if (k != kBuf)
+    hlr_free (k);
+}
+
+static double *scratchGet (Array scratch,int num) {
+  // returns room for num doubles in scratch, or allocated if scratch is NULL
+  if (scratch == NULL)
+    return (double *)hlr_malloc (num * sizeof (double));
+  arraySetMax (scratch,0);
+  array (scratch,num-1,double) = 0.0;
+  return arrp (scratch,0,double);
+}
+
+void stat_orderStats (double x[],int num,int ranks[],int numRanks,
+                      double values[],Array scratch) {
+  /**
+     Finds several order statistics in one pass in O(num) expected time,
+     without changing x
+     @param[in] x - the values
+     @param[in] num - how many
+     @param[in] ranks - 0-based ranks, e.g. 0 for the minimum and num-1
+                        for the maximum; in any order, duplicates allowed
+     @param[in] numRanks - number of ranks
+     @param[in] scratch - an Array of double reused as work space to
+                          avoid an allocation per call; NULL to allocate
+                          work space temporarily
+     @param[out] values - values[i] is the value of rank ranks[i]
+  */
+  double *a;
+
+  if (num <= 0)
+    die ("stat_orderStats: Invalid number of observations: %d",num);
+  a = scratchGet (scratch,num);
+  memcpy (a,x,num * sizeof (double));
+  orderStatsInPlace (a,num,ranks,numRanks,values);
+  if (scratch == NULL)
+    hlr_free (a);
+}
+
+double stat_medianP (double x[],int num,Array scratch) {
+  /**
+     Same as stat_median(), but in O(num) and x is not changed.<br>
+     Suffix 'P' stands for 'Preserving its input'
+     @param[in] x - the values
+     @param[in] num - how many
+     @param[in] scratch - work space, see stat_orderStats(); NULL ok
+     @return the median
+  */
+  int ranks[2];
+  double v[2];
+
+  if (num <= 0)
+    die ("stat_medianP: Invalid number of observations: %d",num);
+  ranks[0] = (num - 1) / 2;
+  ranks[1] = num / 2;
+  stat_orderStats (x,num,ranks,2,v,scratch);
+  return ranks[0] == ranks[1] ? v[1] : 0.5 * (v[0] + v[1]);
+}
+
+double stat_median_quartP (double x[],int num,double *q25,double *q75,
+                           Array scratch) {
+  /**
+     Same as stat_median_quart(), but in O(num) and x is not changed.<br>
+     Suffix 'P' stands for 'Preserving its input'
+     @param[in] x - the values
+     @param[in] num - how many
+     @param[in] scratch - work space, see stat_orderStats(); NULL ok
+     @return the median
+     @param[out] q25 - the 25% quartile
+     @param[out] q75 - the 75% quartile
+  */
+  int n[3];
+  double m[3];
+  int ranks[6];
+  double v[6];
+  int i;
+
+  if (num <= 0)
+    die ("stat_median_quartP: Invalid number of observations: %d",num);
+  n[0] = (num-1)/2;
+  m[0] = (double)(num-1)/2.0 - n[0];
+  n[1] = (num-1)/4;
+  m[1] = (double)(num-1)/4.0 - n[1];
+  n[2] = 3*(num-1)/4;
+  m[2] = 3*(num-1)/4.0 - n[2];
+  for (i=0;i<3;i++) {
+    ranks[2*i] = n[i];
+    ranks[2*i+1] = n[i] + 1 < num ? n[i] + 1 : n[i];
+  }
+  stat_orderStats (x,num,ranks,6,v,scratch);
+  if (q25)
+    *q25 = mq_interpolate (v[2],v[3],m[1]);
+  if (q75)
+    *q75 = mq_interpolate (v[4],v[5],m[2]);
+  return mq_interpolate (v[0],v[1],m[0]);
+}
+
+double stat_median_abs_devP (double x[],int num,Array scratch) {
+  /**
+     Same as stat_median_abs_dev(), but in O(num) and x is not changed.<br>
+     Suffix 'P' stands for 'Preserving its input'
+     @param[in] x - the values
+     @param[in] num - how many
+     @param[in] scratch - work space, see stat_orderStats(); NULL ok
+     @return the median
+  */
+  double *dev;
+  double median;
+  int ranks[2];
+  double v[2];
+  int i;
+
+  median = stat_medianP (x,num,scratch);
+  dev = scratchGet (scratch,num);
+  for (i=0;i<num;i++)
+    dev[i] = fabs (x[i] - median);
+  ranks[0] = (num - 1) / 2;
+  ranks[1] = num / 2;
+  orderStatsInPlace (dev,num,ranks,2,v);
+  if (scratch == NULL)
+    hlr_free (dev);
+  return ranks[0] == ranks[1] ? v[1] : 0.5 * (v[0] + v[1]);
+}
+
+double stat_percentileP (double x[],int num,double p,Array scratch) {
+  /**
+     Same as stat_percentile(), but in O(num) and x is not changed.<br>
+     Suffix 'P' stands for 'Preserving its input'
+     @param[in] x - the values
+     @param[in] num - how many
+     @param[in] p - which percentile
+     @param[in] scratch - work space, see stat_orderStats(); NULL ok
+     @return the percentile value
+  */
+  int ranks[2];
+  double v[2];
+  double z;
+
+  if (num <= 0)
+    die ("stat_percentileP: Invalid number of observations: %d",num);
+  if (p<=0.0 || p>=100.0)
+    die ("stat_percentileP: Invalid percentage: %f",p);
+  z = (p/100.0)*(1.0*num-1);
+  ranks[0] = (int)floor (z);
+  ranks[1] = (int)ceil (z);
+  stat_orderStats (x,num,ranks,2,v,scratch);
+  if (z == floor (z))
+    return v[0];
+  return 0.5 * (v[0] + v[1]);
 }
 
 double stat_variance (double x[],int num) {
@@ -315,7 +564,7 @@ double stat_skew (double x[],int num) {
   sum = 0.0;
   for (i=0;i<num;i++)
     sum += pow ((x[i]-m),3.0);
-  return num*sum/((num-1)*(num-2)*pow(s,3.0));
+  return (double)num*sum/((num-1.0)*(num-2.0)*pow(s,3.0));
 }
 
 double stat_kurt (double x[],int num) {
@@ -337,7 +586,8 @@ double stat_kurt (double x[],int num) {
   sum = 0.0;
   for (i=0;i<num;i++)
     sum += pow ((x[i]-m),4.0);
-  return num*(num+1)*sum/((num-1)*(num-2)*(num-3)*pow(s,4.0)) - 3*(num-1)*(num-1)/((num-2)*(num-3));
+  return (double)num*(num+1.0)*sum/((num-1.0)*(num-2.0)*(num-3.0)*pow(s,4.0)) -
+    3.0*(num-1.0)*(num-1.0)/((num-2.0)*(num-3.0));
 }
 
 double stat_percentile (double x[],int num,double p) {
@@ -371,16 +621,24 @@ double stat_ma68 (double x[],int num) {
   */
 
   double *med_dev;
-  double m;
+  double m,z;
   int i;
+  int ranks[2];
+  double v[2];
 
   med_dev = mv_vectorD (num);
   m = stat_median (x,num);
   for (i=0;i<num;i++)
     med_dev[i]=fabs (x[i]-m);
-  m = stat_percentile (med_dev,num,68.0);
+  // the 68th percentile as in stat_percentile(), med_dev is ours to rearrange
+  z = 0.68*(1.0*num-1);
+  ranks[0] = (int)floor (z);
+  ranks[1] = (int)ceil (z);
+  orderStatsInPlace (med_dev,num,ranks,2,v);
   mv_freeVectorD (med_dev);
-  return m;
+  if (z == floor (z))
+    return v[0];
+  return 0.5 * (v[0] + v[1]);
 }
 
 double stat_span (double x[],int num) {
@@ -1356,7 +1614,7 @@ void stat_bootstrap (double *val,int count,int *seed,int rep,
     array (bsMeans,arrayMax (bsMeans),double) = av;
     *mean += av;
   }
-  arraySort (bsMeans,(ARRAYORDERF)&arrayDoublecmp);
+  arraySortDouble (bsMeans);
   *mean /= rep;
   index = -1;
   for (i=1;i<100;i++) {
@@ -1368,19 +1626,158 @@ void stat_bootstrap (double *val,int count,int *seed,int rep,
   arrayDestroy (bsMeans);
 }
 
+/* ------------- splitting work among threads --------------- */
+
+/// number of values from which on work is split among threads
+#define STAT_PARALLEL_MIN 262144
+
+static int statThreadCount (double work,int n) {
+  /**
+     @param[in] work - number of values to process
+     @param[in] n - number of independent parts, e.g. rows
+     @return number of threads to use, 1 means work serially
+  */
+  int nThreads = 1;
+
+#if defined (PLABLA_HAVE_PTHREAD) && defined (_SC_NPROCESSORS_ONLN)
+  if (work >= STAT_PARALLEL_MIN) {
+    nThreads = (int)sysconf (_SC_NPROCESSORS_ONLN);
+    if (nThreads > work / (STAT_PARALLEL_MIN / 4))
+      nThreads = (int)(work / (STAT_PARALLEL_MIN / 4));
+    if (nThreads > n)
+      nThreads = n;
+    if (nThreads < 1)
+      nThreads = 1;
+  }
+#endif
+  return nThreads;
+}
+
+static void statRunJobs (void *jobs,int nJobs,size_t jobSize,
+                         void *(*fn)(void *)) {
+  /**
+     Run fn() on each of the jobs, each in its own thread;
+     the last job runs in the calling thread
+  */
+  int i;
+#ifdef PLABLA_HAVE_PTHREAD
+  pthread_t *tids;
+  char *started;
+
+  if (nJobs > 1) {
+    tids = (pthread_t *)hlr_malloc (nJobs * sizeof (pthread_t));
+    started = (char *)hlr_calloc (nJobs,1);
+    for (i=0;i<nJobs-1;i++)
+      started[i] = pthread_create (&tids[i],NULL,fn,
+                                   (char *)jobs + i * jobSize) == 0;
+    fn ((char *)jobs + (nJobs - 1) * jobSize);
+    for (i=0;i<nJobs-1;i++)
+      if (started[i])
+        pthread_join (tids[i],NULL);
+      else
+        fn ((char *)jobs + i * jobSize);
+    hlr_free (started);
+    hlr_free (tids);
+    return;
+  }
+#endif
+  for (i=0;i<nJobs;i++)
+    fn ((char *)jobs + i * jobSize);
+}
+
 /* routines for quantile-quantile normalization */
 
-/// an element with its original index
+/// the part of a quantile normalization done by one thread
 typedef struct {
-  int index; //!< index
-  double value; //!< value
-}IndexedValue;
+  double **x; //!< the vectors
+  int dim; //!< number of components of each vector
+  int lo; //!< first vector of this job
+  int hi; //!< end of the vectors of this job
+  double *values; //!< stat_qq(): sums of the i-th smallest components;
+                  //!< stat_qq_fixed(): the values to enforce
+  int *order; //!< room for the order of one vector
+  Array work; //!< work space for sorting
+}QqJob;
+
+static void *qqRankJob (void *arg) {
+  /**
+     Adds the sorted components of each vector to values and replaces
+     each component by its rank
+  */
+  QqJob *job = (QqJob *)arg;
+  double *x;
+  int i,r;
+
+  for (i=job->lo;i<job->hi;i++) {
+    x = job->x[i];
+    arrayOrderDoubles (x,job->dim,job->order,job->work);
+    for (r=0;r<job->dim;r++) {
+      job->values[r] += x[job->order[r]];
+      x[job->order[r]] = r;
+    }
+  }
+  return NULL;
+}
+
+static void *qqReplaceRankJob (void *arg) {
+  /**
+     Replaces each rank by the value of the reference distribution
+  */
+  QqJob *job = (QqJob *)arg;
+  double *x;
+  int i,j;
 
-static int sort_indexedValues (IndexedValue *a,IndexedValue *b) {
+  for (i=job->lo;i<job->hi;i++) {
+    x = job->x[i];
+    for (j=0;j<job->dim;j++)
+      x[j] = job->values[(int)x[j]];
+  }
+  return NULL;
+}
+
+static void *qqFixedJob (void *arg) {
   /**
-     Private; needed for sorting indexed values by value
+     Replaces the i-th smallest component of each vector by values[i]
   */
-  return (a->value > b->value) ? 1 : -1;
+  QqJob *job = (QqJob *)arg;
+  double *x;
+  int i,r;
+
+  for (i=job->lo;i<job->hi;i++) {
+    x = job->x[i];
+    arrayOrderDoubles (x,job->dim,job->order,job->work);
+    for (r=0;r<job->dim;r++)
+      x[job->order[r]] = job->values[r];
+  }
+  return NULL;
+}
+
+static QqJob *qqJobsCreate (double **x,int n,int dim,int nJobs,
+                            double *values) {
+  QqJob *jobs = (QqJob *)hlr_calloc (nJobs,sizeof (QqJob));
+  int i;
+
+  for (i=0;i<nJobs;i++) {
+    jobs[i].x = x;
+    jobs[i].dim = dim;
+    jobs[i].lo = (int)((long)n * i / nJobs);
+    jobs[i].hi = (int)((long)n * (i + 1) / nJobs);
+    jobs[i].values = values != NULL ? values :
+      (double *)hlr_calloc (dim,sizeof (double));
+    jobs[i].order = (int *)hlr_malloc (dim * sizeof (int));
+    jobs[i].work = arrayCreate (dim * 3,double);
+  }
+  return jobs;
+}
+
+static void qqJobsDestroy (QqJob *jobs,int nJobs) {
+  int i;
+
+  for (i=0;i<nJobs;i++) {
+    hlr_free (jobs[i].order);
+    arrayDestroy (jobs[i].work);
+  }
+  hlr_free (jobs);
 }
 
 void stat_qq (double **x,int n,int dim,double *values) {
@@ -1389,7 +1786,12 @@ void stat_qq (double **x,int n,int dim,double *values) {
      components; the distribution of values is then identical for all resulting
      vectors;<br>
      Memory for array "values" has to be allocated and managed by caller;
-     dimension of values is values[dim]
+     dimension of values is values[dim].<br>
+     The vectors are sorted by radix sort, several at a time in
+     threads for large data; while sorting, the reference distribution
+     is summed up and each component replaced by its rank, so the only
+     memory needed is a few vectors per thread. Equal components of a
+     vector get consecutive ranks in the order of their positions.
      @param[in] x - data to be normalized; x has dimension x[n][dim]
      @param[in] n = number of rows of x
      @param[in] dim - number of columns of x
@@ -1398,38 +1800,31 @@ void stat_qq (double **x,int n,int dim,double *values) {
                           obtained after normalization is returned for later
                           use, e.g. as input parameter for stat_qq_fixed()
   */
-  Array *tmp;
-  double tmpmean;
+  int nJobs = statThreadCount ((double)n * dim,n);
+  QqJob *jobs;
+  double *reference;
   int i,j;
 
-  // allocate memory for temporary data
-  tmp = (Array *)hlr_calloc (n,sizeof(Array));
-  for (i=0;i<n;i++)
-    tmp[i] = arrayCreate (dim,IndexedValue);
-  // initialize temporary space
-  for (i=0;i<n;i++)
-    for (j=0;j<dim;j++) {
-      array (tmp[i],j,IndexedValue).value = x[i][j];
-      arru (tmp[i],j,IndexedValue).index = j;
-    }
-  // first step of QQ: sort all vectors
-  for (i=0;i<n;i++)
-    arraySort (tmp[i],(ARRAYORDERF)&sort_indexedValues);
-  // next, calculate means over all rows and replace original data by QQ normalized values
+  if (n <= 0 || dim <= 0)
+    return;
+  jobs = qqJobsCreate (x,n,dim,nJobs,NULL);
+  statRunJobs (jobs,nJobs,sizeof (QqJob),qqRankJob);
+  // reduce: the mean of the i-th smallest components over all vectors
+  reference = jobs[0].values;
+  for (i=1;i<nJobs;i++) {
+    for (j=0;j<dim;j++)
+      reference[j] += jobs[i].values[j];
+    hlr_free (jobs[i].values);
+    jobs[i].values = reference;
+  }
   for (j=0;j<dim;j++) {
-    tmpmean = 0.0;
-    for (i=0;i<n;i++)
-      tmpmean += arru (tmp[i],j,IndexedValue).value;
-    tmpmean /= n;
+    reference[j] /= n;
     if (values != NULL)
-      values[j] = tmpmean;
-    for (i=0;i<n;i++)
-      x[i][arru (tmp[i],j,IndexedValue).index] = tmpmean;
+      values[j] = reference[j];
   }
-  // finally, free allocated memory
-  for (i=0;i<n;i++)
-    arrayDestroy (tmp[i]);
-  hlr_free (tmp);
+  statRunJobs (jobs,nJobs,sizeof (QqJob),qqReplaceRankJob);
+  qqJobsDestroy (jobs,nJobs);
+  hlr_free (reference);
 }
 
 void stat_qq_fixed  (double **x,int n,int dim,double *values) {
@@ -1437,7 +1832,9 @@ void stat_qq_fixed  (double **x,int n,int dim,double *values) {
      Enforces a fixed distribution on a set of n vectors with dim components;
      the values used to fill.<br>
      Memory for array "values" has to be allocated and managed by caller;
-     dimension of values is values[dim]
+     dimension of values is values[dim].<br>
+     Use this to normalize new batches of vectors to the reference
+     distribution of an earlier stat_qq() without normalizing all again.
      @param[in] x - data to be normalized; x has dimension x[n][dim]
      @param[in] n - number of rows of x
      @param[in] dim - number of columns of x
@@ -1446,23 +1843,14 @@ void stat_qq_fixed  (double **x,int n,int dim,double *values) {
                           the output from stat_qq() can be directly used as
                           input at this point
   */
-  Array tmp;
-  int i,j;
+  int nJobs = statThreadCount ((double)n * dim,n);
+  QqJob *jobs;
 
-  tmp=arrayCreate (dim,IndexedValue);
-  for (i=0;i<n;i++) { // loop over all vectors
-    // initialize temporary space
-    for (j=0;j<dim;j++) {
-      array (tmp,j,IndexedValue).value = x[i][j];
-      arru (tmp,j,IndexedValue).index = j;
-    }
-    // sort vector
-    arraySort (tmp,(ARRAYORDERF)&sort_indexedValues);
-    // then, replace values in original vectors by user specified ones
-    for (j=0;j<dim;j++)
-      x[i][arru (tmp,j,IndexedValue).index] = values[j];
-  }
-  arrayDestroy (tmp);
+  if (n <= 0 || dim <= 0)
+    return;
+  jobs = qqJobsCreate (x,n,dim,nJobs,values);
+  statRunJobs (jobs,nJobs,sizeof (QqJob),qqFixedJob);
+  qqJobsDestroy (jobs,nJobs);
 }
 
 /* Gini Inequality index */
@@ -1489,6 +1877,746 @@ double stat_gini (double x[],int num) {
   return gini - 1.0 - (1.0/(double)num);
 }
 
+/* ------------- summary statistics of all rows or columns --------------- */
+
+/// number of columns summarized together by stat_matrixSummary()
+#define STAT_COLBLOCK 8
+
+/// the part of a stat_matrixSummary() done by one thread
+typedef struct {
+  double **m; //!< the matrix
+  int nr; //!< number of rows
+  int nc; //!< number of columns
+  int axis; //!< STAT_ROWS or STAT_COLS
+  int flags; //!< STAT_SUMMARY_* flags
+  StatSummary *out; //!< where to put the results
+  int lo; //!< first row or column of this job
+  int hi; //!< end of the rows or columns of this job
+  double *scratch; //!< room for a row or column
+  double *block; //!< STAT_COLS: room for STAT_COLBLOCK columns
+}StatSummaryJob;
+
+static void summarizeVector (double *x,int n,int flags,StatSummary *out,
+                             int i,double *scratch) {
+  /**
+     Computes the statistics requested in 'flags' of x[0..n-1] and puts
+     them into element i of the arrays of 'out': one pass for sum,
+     minimum and maximum, one for the moments about the mean and
+     selection in 'scratch' (n doubles) for median and MAD
+  */
+  double sum,mn,mx,mean,d,d2,s2,s3,s4,sd,v[2];
+  int k,ranks[2];
+#ifdef __SSE2__
+  double lanes[2];
+  __m128d vx,vd,vd2;
+#endif
+
+  sum = 0.0;
+  mn = mx = x[0];
+  k = 0;
+#ifdef __SSE2__
+  {
+    __m128d vsum = _mm_setzero_pd ();
+    __m128d vmin = _mm_set1_pd (x[0]);
+    __m128d vmax = vmin;
+    for (;k+2<=n;k+=2) {
+      vx = _mm_loadu_pd (x + k);
+      vsum = _mm_add_pd (vsum,vx);
+      vmin = _mm_min_pd (vmin,vx);
+      vmax = _mm_max_pd (vmax,vx);
+    }
+    _mm_storeu_pd (lanes,vsum);
+    sum = lanes[0] + lanes[1];
+    _mm_storeu_pd (lanes,vmin);
+    mn = lanes[0] < lanes[1] ? lanes[0] : lanes[1];
+    _mm_storeu_pd (lanes,vmax);
+    mx = lanes[0] > lanes[1] ? lanes[0] : lanes[1];
+  }
+#endif
+  for (;k<n;k++) {
+    sum += x[k];
+    if (x[k] < mn)
+      mn = x[k];
+    if (x[k] > mx)
+      mx = x[k];
+  }
+  mean = sum / n;
+  if (flags & STAT_SUMMARY_MEAN)
+    out->mean[i] = mean;
+  if (flags & STAT_SUMMARY_MIN)
+    out->min[i] = mn;
+  if (flags & STAT_SUMMARY_MAX)
+    out->max[i] = mx;
+
+  if (flags & (STAT_SUMMARY_VARIANCE | STAT_SUMMARY_STDDEV |
+               STAT_SUMMARY_SKEW | STAT_SUMMARY_KURT)) {
+    s2 = s3 = s4 = 0.0;
+    k = 0;
+#ifdef __SSE2__
+    {
+      __m128d vmean = _mm_set1_pd (mean);
+      __m128d vs2 = _mm_setzero_pd ();
+      __m128d vs3 = _mm_setzero_pd ();
+      __m128d vs4 = _mm_setzero_pd ();
+      for (;k+2<=n;k+=2) {
+        vd = _mm_sub_pd (_mm_loadu_pd (x + k),vmean);
+        vd2 = _mm_mul_pd (vd,vd);
+        vs2 = _mm_add_pd (vs2,vd2);
+        vs3 = _mm_add_pd (vs3,_mm_mul_pd (vd2,vd));
+        vs4 = _mm_add_pd (vs4,_mm_mul_pd (vd2,vd2));
+      }
+      _mm_storeu_pd (lanes,vs2);
+      s2 = lanes[0] + lanes[1];
+      _mm_storeu_pd (lanes,vs3);
+      s3 = lanes[0] + lanes[1];
+      _mm_storeu_pd (lanes,vs4);
+      s4 = lanes[0] + lanes[1];
+    }
+#endif
+    for (;k<n;k++) {
+      d = x[k] - mean;
+      d2 = d * d;
+      s2 += d2;
+      s3 += d2 * d;
+      s4 += d2 * d2;
+    }
+    sd = n > 1 ? sqrt (s2 / (n - 1)) : 0.0;
+    if (flags & STAT_SUMMARY_VARIANCE)
+      out->variance[i] = n > 1 ? s2 / (n - 1) : 0.0;
+    if (flags & STAT_SUMMARY_STDDEV)
+      out->stddev[i] = sd;
+    if (flags & STAT_SUMMARY_SKEW)
+      out->skew[i] = n < 3 || sd == 0.0 ? STAT_INVALID :
+        n * s3 / ((n - 1.0) * (n - 2.0) * sd * sd * sd);
+    if (flags & STAT_SUMMARY_KURT)
+      out->kurt[i] = n < 4 || sd == 0.0 ? STAT_INVALID :
+        n * (n + 1.0) * s4 / ((n - 1.0) * (n - 2.0) * (n - 3.0) * sd * sd * sd * sd) -
+        3.0 * (n - 1) * (n - 1) / ((n - 2.0) * (n - 3.0));
+  }
+
+  if (flags & (STAT_SUMMARY_MEDIAN | STAT_SUMMARY_MAD)) {
+    ranks[0] = (n - 1) / 2;
+    ranks[1] = n / 2;
+    memcpy (scratch,x,n * sizeof (double));
+    orderStatsInPlace (scratch,n,ranks,2,v);
+    d = 0.5 * (v[0] + v[1]);
+    if (flags & STAT_SUMMARY_MEDIAN)
+      out->median[i] = d;
+    if (flags & STAT_SUMMARY_MAD) {
+      for (k=0;k<n;k++)
+        scratch[k] = fabs (x[k] - d);
+      orderStatsInPlace (scratch,n,ranks,2,v);
+      out->mad[i] = 0.5 * (v[0] + v[1]);
+    }
+  }
+}
+
+static void *summaryJob (void *arg) {
+  /**
+     Summarizes the rows or columns lo..hi-1 of one job; columns are
+     copied in blocks into contiguous memory first
+  */
+  StatSummaryJob *job = (StatSummaryJob *)arg;
+  double *block = job->block;
+  double *row;
+  int i,j,b,nb;
+
+  if (job->axis == STAT_ROWS) {
+    for (i=job->lo;i<job->hi;i++)
+      summarizeVector (job->m[i],job->nc,job->flags,job->out,i,job->scratch);
+    return NULL;
+  }
+  for (j=job->lo;j<job->hi;j+=STAT_COLBLOCK) {
+    nb = job->hi - j < STAT_COLBLOCK ? job->hi - j : STAT_COLBLOCK;
+    for (i=0;i<job->nr;i++) {
+      row = job->m[i] + j;
+      for (b=0;b<nb;b++)
+        block[(size_t)b * job->nr + i] = row[b];
+    }
+    for (b=0;b<nb;b++)
+      summarizeVector (block + (size_t)b * job->nr,job->nr,job->flags,
+                       job->out,j + b,job->scratch);
+  }
+  return NULL;
+}
+
+void stat_matrixSummary (double **m,int nr,int nc,int axis,int flags,
+                         StatSummary *out) {
+  /**
+     Computes summary statistics of every row or every column of a
+     matrix, e.g. from mv_matrixD(). This is faster than calling
+     stat_mean(), stat_stddev(), stat_median() etc. for each row:
+     all moments are computed in two passes over the data, median and
+     MAD by selection, and large matrices are split among threads.<br>
+     The results are those of the single functions, except for rounding:
+     the variance is computed from the deviations from the mean, which
+     is more accurate than stat_variance()
+     @param[in] m - the matrix, not changed
+     @param[in] nr - number of rows
+     @param[in] nc - number of columns
+     @param[in] axis - STAT_ROWS for statistics of each row,
+                       STAT_COLS for statistics of each column
+     @param[in] flags - the statistics to compute: STAT_SUMMARY_MEAN,
+                        STAT_SUMMARY_VARIANCE etc. combined with '|'
+     @param[in] out - for each statistic requested, an array with nr
+                      (STAT_ROWS) or nc (STAT_COLS) elements
+     @param[out] out - the arrays filled
+  */
+  StatSummaryJob *jobs;
+  int n = axis == STAT_ROWS ? nr : nc;
+  int nThreads;
+  int i;
+
+  if (nr <= 0 || nc <= 0)
+    die ("stat_matrixSummary: Invalid matrix size %d x %d",nr,nc);
+  if (axis != STAT_ROWS && axis != STAT_COLS)
+    die ("stat_matrixSummary: Invalid axis %d",axis);
+  if ((flags & STAT_SUMMARY_MEAN && out->mean == NULL) ||
+      (flags & STAT_SUMMARY_VARIANCE && out->variance == NULL) ||
+      (flags & STAT_SUMMARY_STDDEV && out->stddev == NULL) ||
+      (flags & STAT_SUMMARY_MEDIAN && out->median == NULL) ||
+      (flags & STAT_SUMMARY_MAD && out->mad == NULL) ||
+      (flags & STAT_SUMMARY_SKEW && out->skew == NULL) ||
+      (flags & STAT_SUMMARY_KURT && out->kurt == NULL) ||
+      (flags & STAT_SUMMARY_MIN && out->min == NULL) ||
+      (flags & STAT_SUMMARY_MAX && out->max == NULL))
+    die ("stat_matrixSummary: no output array for a statistic requested");
+  nThreads = statThreadCount ((double)nr * nc,n);
+  jobs = (StatSummaryJob *)hlr_calloc (nThreads,sizeof (StatSummaryJob));
+  for (i=0;i<nThreads;i++) {
+    jobs[i].m = m;
+    jobs[i].nr = nr;
+    jobs[i].nc = nc;
+    jobs[i].axis = axis;
+    jobs[i].flags = flags;
+    jobs[i].out = out;
+    jobs[i].lo = (int)((long)n * i / nThreads);
+    jobs[i].hi = (int)((long)n * (i + 1) / nThreads);
+    jobs[i].scratch = (double *)hlr_malloc ((axis == STAT_ROWS ? nc : nr) *
+                                            sizeof (double));
+    jobs[i].block = axis == STAT_ROWS ? NULL :
+      (double *)hlr_malloc ((size_t)STAT_COLBLOCK * nr * sizeof (double));
+  }
+  statRunJobs (jobs,nThreads,sizeof (StatSummaryJob),summaryJob);
+  for (i=0;i<nThreads;i++) {
+    hlr_free (jobs[i].scratch);
+    hlr_free (jobs[i].block);
+  }
+  hlr_free (jobs);
+}
+
+/* ------------- quantiles of streams: t-digest --------------- */
+
+/// begins a serialized StatSketch
+#define STAT_SKETCH_MAGIC "BIOSTDG"
+/// stored as is, to recognize data from machines with other byte order
+#define STAT_SKETCH_BYTEORDER 0x01020304
+/// version of the serialized format
+#define STAT_SKETCH_VERSION 1
+
+/// header of a serialized StatSketch, followed by the means and weights
+typedef struct {
+  char magic[8]; //!< STAT_SKETCH_MAGIC
+  int byteOrder; //!< STAT_SKETCH_BYTEORDER
+  int version; //!< STAT_SKETCH_VERSION
+  double compression; //!< see stat_sketchCreate()
+  double total; //!< number of values
+  double min; //!< smallest value
+  double max; //!< largest value
+  int num; //!< number of centroids
+  int unused; //!< padding, 0
+}StatSketchHeader;
+
+static double sketchNextQ (double compression,double q) {
+  /**
+     The scale function k(q) = compression/(2 pi) * asin(2q - 1) allows
+     small centroids at the tails and large ones near the median
+     @return q' with k(q') = k(q) + 1, the largest quantile a
+             centroid starting at q may reach
+  */
+  double x = asin (2.0 * q - 1.0) + 2.0 * M_PI / compression;
+
+  if (x >= M_PI / 2.0)
+    return 1.0;
+  return (sin (x) + 1.0) / 2.0;
+}
+
+static void sketchCompress (StatSketch this1) {
+  /**
+     Merges centroids and the values not yet compressed into at most
+     maxCentroids centroids, sorted by mean
+  */
+  double *tmp;
+  double m,w,wSoFar,wLimit;
+  int i,j,out;
+
+  if (this1->num == this1->numCompressed)
+    return;
+  arrayOrderDoubles (this1->mean,this1->num,this1->order,this1->work);
+  j = this1->order[0];
+  m = this1->mean[j];
+  w = this1->weight[j];
+  wSoFar = 0.0;
+  wLimit = this1->total * sketchNextQ (this1->compression,0.0);
+  out = 0;
+  for (i=1;i<this1->num;i++) {
+    j = this1->order[i];
+    if (wSoFar + w + this1->weight[j] <= wLimit) {
+      w += this1->weight[j];
+      m += (this1->mean[j] - m) * this1->weight[j] / w;
+      continue;
+    }
+    this1->tmpMean[out] = m;
+    this1->tmpWeight[out++] = w;
+    wSoFar += w;
+    wLimit = this1->total *
+      sketchNextQ (this1->compression,wSoFar / this1->total);
+    m = this1->mean[j];
+    w = this1->weight[j];
+  }
+  this1->tmpMean[out] = m;
+  this1->tmpWeight[out++] = w;
+  tmp = this1->mean;
+  this1->mean = this1->tmpMean;
+  this1->tmpMean = tmp;
+  tmp = this1->weight;
+  this1->weight = this1->tmpWeight;
+  this1->tmpWeight = tmp;
+  this1->num = this1->numCompressed = out;
+}
+
+static void sketchAddWeighted (StatSketch this1,double x,double w) {
+  if (this1->num == this1->room)
+    sketchCompress (this1);
+  if (this1->total == 0.0)
+    this1->min = this1->max = x;
+  else if (x < this1->min)
+    this1->min = x;
+  else if (x > this1->max)
+    this1->max = x;
+  this1->mean[this1->num] = x;
+  this1->weight[this1->num++] = w;
+  this1->total += w;
+}
+
+StatSketch stat_sketchCreate (double compression) {
+  /**
+     Creates a sketch to estimate quantiles of a stream of values too large
+     to keep in memory (t-digest, Dunning and Ertl 2019). The memory used
+     depends only on the compression, not on the number of values.
+     Sketches of parts of the data, e.g. made in parallel, can be combined
+     with stat_sketchMerge() and passed around with stat_sketchSerialize().
+     Postcondition: stat_sketchAdd() etc. can be called
+     @param[in] compression - the accuracy: the sketch keeps about
+                              compression centroids; with 100, the error of
+                              the median is typically well below 1% of the
+                              rank and much smaller at the tails;
+                              at least 10
+     @return the sketch; to be destroyed with stat_sketchDestroy()
+  */
+  StatSketch this1;
+
+  if (compression < 10.0 || compression > 1e6)
+    die ("stat_sketchCreate: Invalid compression: %f",compression);
+  this1 = (StatSketch)hlr_calloc (1,sizeof (struct _statSketchStruct_));
+  this1->compression = compression;
+  this1->maxCentroids = (int)ceil (compression) + 4;
+  this1->room = 5 * this1->maxCentroids;
+  this1->mean = (double *)hlr_malloc (this1->room * sizeof (double));
+  this1->weight = (double *)hlr_malloc (this1->room * sizeof (double));
+  this1->tmpMean = (double *)hlr_malloc (this1->room * sizeof (double));
+  this1->tmpWeight = (double *)hlr_malloc (this1->room * sizeof (double));
+  this1->order = (int *)hlr_malloc (this1->room * sizeof (int));
+  this1->work = arrayCreate (this1->room * 3,double);
+  return this1;
+}
+
+void stat_sketchDestroyFunc (StatSketch this1) {
+  /**
+     Destroys a sketch; do not call this function, use the macro
+     stat_sketchDestroy()
+     @param[in] this1 - the sketch
+  */
+  if (this1 == NULL)
+    return;
+  hlr_free (this1->mean);
+  hlr_free (this1->weight);
+  hlr_free (this1->tmpMean);
+  hlr_free (this1->tmpWeight);
+  hlr_free (this1->order);
+  arrayDestroy (this1->work);
+  hlr_free (this1);
+}
+
+void stat_sketchAdd (StatSketch this1,double x) {
+  /**
+     Adds a value to a sketch
+     @param[in] this1 - the sketch
+     @param[in] x - the value
+  */
+  sketchAddWeighted (this1,x,1.0);
+}
+
+void stat_sketchAddValues (StatSketch this1,double x[],int num) {
+  /**
+     Adds values to a sketch
+     @param[in] this1 - the sketch
+     @param[in] x - the values
+     @param[in] num - how many
+  */
+  int i;
+
+  for (i=0;i<num;i++)
+    sketchAddWeighted (this1,x[i],1.0);
+}
+
+void stat_sketchMerge (StatSketch this1,StatSketch other) {
+  /**
+     Adds the values summarized by another sketch; the result is about as
+     accurate as a sketch made from all values
+     @param[in] this1 - the sketch to add to; keeps its compression
+     @param[in] other - another sketch, not changed
+  */
+  int i;
+
+  if (this1 == other)
+    die ("stat_sketchMerge: Cannot merge a sketch with itself");
+  if (other->total == 0.0)
+    return;
+  for (i=0;i<other->num;i++)
+    sketchAddWeighted (this1,other->mean[i],other->weight[i]);
+  if (other->min < this1->min)
+    this1->min = other->min;
+  if (other->max > this1->max)
+    this1->max = other->max;
+}
+
+double stat_sketchCount (StatSketch this1) {
+  /**
+     @param[in] this1 - the sketch
+     @return number of values added, including those of merged sketches
+  */
+  return this1->total;
+}
+
+double stat_sketchQuantile (StatSketch this1,double q) {
+  /**
+     Estimates a quantile of the values added; for less than
+     compression/2 values the result is exact, interpolating linearly
+     between neighboring values (unlike stat_percentile(), which takes
+     their mean)
+     @param[in] this1 - the sketch
+     @param[in] q - 0 <= q <= 1, 0 gives the minimum, 1 the maximum
+     @return the estimated quantile
+  */
+  double target,center,next;
+  int i,last;
+
+  if (this1->total == 0.0)
+    die ("stat_sketchQuantile: No observations");
+  if (q < 0.0 || q > 1.0)
+    die ("stat_sketchQuantile: Invalid quantile: %f",q);
+  sketchCompress (this1);
+  if (this1->num == 1)
+    return this1->mean[0];
+  // position on the cumulative weight where the centroid means are at
+  // the center of their weight, i.e. singletons at 0.5, 1.5, ...;
+  // the minimum is at 0.5 and the maximum at total - 0.5, like singletons
+  target = q * (this1->total - 1.0) + 0.5;
+  if (target <= 0.5)
+    return this1->min;
+  center = this1->weight[0] / 2.0;
+  if (target < center)
+    return this1->min + (this1->mean[0] - this1->min) *
+      (target - 0.5) / (center - 0.5);
+  for (i=0;i<this1->num-1;i++) {
+    next = center + (this1->weight[i] + this1->weight[i+1]) / 2.0;
+    if (target < next)
+      return this1->mean[i] + (this1->mean[i+1] - this1->mean[i]) *
+        (target - center) / (next - center);
+    center = next;
+  }
+  last = this1->num - 1;
+  if (target >= this1->total - 0.5)
+    return this1->max;
+  return this1->mean[last] + (this1->max - this1->mean[last]) *
+    (target - center) / (this1->total - 0.5 - center);
+}
+
+double stat_sketchPercentile (StatSketch this1,double p) {
+  /**
+     Estimates a percentile of the values added
+     @param[in] this1 - the sketch
+     @param[in] p - 0 <= p <= 100
+     @return the estimated percentile, see stat_sketchQuantile()
+  */
+  if (p < 0.0 || p > 100.0)
+    die ("stat_sketchPercentile: Invalid percentage: %f",p);
+  return stat_sketchQuantile (this1,p / 100.0);
+}
+
+void stat_sketchSerialize (StatSketch this1,Array bytes) {
+  /**
+     Appends a compact representation of a sketch to bytes, e.g. to
+     write it to a file or send it to another process
+     @param[in] this1 - the sketch
+     @param[in] bytes - Array of char
+     @param[out] bytes - stat_sketchDeserialize() of what was added
+                         gives a sketch equivalent to this1
+  */
+  StatSketchHeader h;
+  int start = arrayMax (bytes);
+  int len;
+
+  sketchCompress (this1);
+  memset (&h,0,sizeof (h));
+  memcpy (h.magic,STAT_SKETCH_MAGIC,sizeof (h.magic));
+  h.byteOrder = STAT_SKETCH_BYTEORDER;
+  h.version = STAT_SKETCH_VERSION;
+  h.compression = this1->compression;
+  h.total = this1->total;
+  h.min = this1->min;
+  h.max = this1->max;
+  h.num = this1->num;
+  len = sizeof (h) + 2 * this1->num * sizeof (double);
+  arraySetMax (bytes,start + len);
+  memcpy (arrp (bytes,start,char),&h,sizeof (h));
+  memcpy (arrp (bytes,start + sizeof (h),char),this1->mean,
+          this1->num * sizeof (double));
+  memcpy (arrp (bytes,start + sizeof (h) + this1->num * sizeof (double),char),
+          this1->weight,this1->num * sizeof (double));
+}
+
+StatSketch stat_sketchDeserialize (char *bytes,int len) {
+  /**
+     Recreates a sketch from the output of stat_sketchSerialize()
+     @param[in] bytes - start of the serialized sketch
+     @param[in] len - number of bytes available
+     @return the sketch, to be destroyed with stat_sketchDestroy();
+             NULL if bytes is not a serialized sketch (see warnReport())
+  */
+  StatSketchHeader h;
+  StatSketch this1;
+  double total = 0.0;
+  int i;
+
+  if (len < sizeof (h)) {
+    warnAdd ("stat_sketchDeserialize","not a sketch");
+    return NULL;
+  }
+  memcpy (&h,bytes,sizeof (h));
+  if (memcmp (h.magic,STAT_SKETCH_MAGIC,sizeof (h.magic)) != 0 ||
+      h.byteOrder != STAT_SKETCH_BYTEORDER ||
+      h.version != STAT_SKETCH_VERSION ||
+      !(h.compression >= 10.0 && h.compression <= 1e6) ||
+      h.num < 0 || h.num > (int)ceil (h.compression) + 4 ||
+      (h.num == 0) != (h.total == 0.0) ||
+      len - sizeof (h) < 2 * h.num * sizeof (double)) {
+    warnAdd ("stat_sketchDeserialize","not a sketch or wrong version");
+    return NULL;
+  }
+  this1 = stat_sketchCreate (h.compression);
+  memcpy (this1->mean,bytes + sizeof (h),h.num * sizeof (double));
+  memcpy (this1->weight,bytes + sizeof (h) + h.num * sizeof (double),
+          h.num * sizeof (double));
+  for (i=0;i<h.num;i++) {
+    if (!(this1->weight[i] > 0.0) || (i > 0 && this1->mean[i] < this1->mean[i-1]))
+      break;
+    total += this1->weight[i];
+  }
+  if (i < h.num || total != h.total || !(h.min <= h.max)) {
+    stat_sketchDestroy (this1);
+    warnAdd ("stat_sketchDeserialize","inconsistent sketch");
+    return NULL;
+  }
+  this1->num = this1->numCompressed = h.num;
+  this1->total = h.total;
+  this1->min = h.min;
+  this1->max = h.max;
+  return this1;
+}
+
+/* ------------- streaming moments --------------- */
+
+void stat_accumInit (StatAccum *a) {
+  /**
+     Prepares an accumulator for stat_accumAdd(); a StatAccum needs no
+     other memory and no destruction
+     @param[in] a - the accumulator
+     @param[out] a - empty
+  */
+  a->n = 0.0;
+  a->mean = 0.0;
+  a->m2 = 0.0;
+  a->m3 = 0.0;
+  a->m4 = 0.0;
+  a->min = 0.0;
+  a->max = 0.0;
+}
+
+void stat_accumAdd (StatAccum *a,double x) {
+  /**
+     Adds one value to an accumulator; the moments are updated in one
+     pass in a numerically stable way (Welford, Pebay 2008), so values can
+     be added as they are read, e.g. from ls_nextLine(), without keeping them
+     @param[in] a - accumulator initialized with stat_accumInit()
+     @param[in] x - the value
+     @param[out] a - updated
+  */
+  double n1 = a->n;
+  double n = n1 + 1.0;
+  double delta = x - a->mean;
+  double deltaN = delta / n;
+  double deltaN2 = deltaN * deltaN;
+  double term1 = delta * deltaN * n1;
+
+  if (n1 == 0.0)
+    a->min = a->max = x;
+  else if (x < a->min)
+    a->min = x;
+  else if (x > a->max)
+    a->max = x;
+  a->n = n;
+  a->mean += deltaN;
+  a->m4 += term1 * deltaN2 * (n * n - 3.0 * n + 3.0) +
+    6.0 * deltaN2 * a->m2 - 4.0 * deltaN * a->m3;
+  a->m3 += term1 * deltaN * (n - 2.0) - 3.0 * deltaN * a->m2;
+  a->m2 += term1;
+}
+
+void stat_accumAddValues (StatAccum *a,double x[],int num) {
+  /**
+     Adds num values to an accumulator, see stat_accumAdd()
+     @param[in] a - accumulator initialized with stat_accumInit()
+     @param[in] x - the values
+     @param[in] num - how many
+     @param[out] a - updated
+  */
+  int i;
+
+  for (i=0;i<num;i++)
+    stat_accumAdd (a,x[i]);
+}
+
+void stat_accumMerge (StatAccum *a,StatAccum *b) {
+  /**
+     Combines two accumulators, e.g. of chunks summarized in different
+     threads; afterwards a describes the values of a and b together,
+     as if they had all been added to a
+     @param[in] a - an accumulator
+     @param[in] b - another accumulator, not changed
+     @param[out] a - updated
+  */
+  double na = a->n;
+  double nb = b->n;
+  double n = na + nb;
+  double delta,delta2,nab;
+
+  if (nb == 0.0)
+    return;
+  if (na == 0.0) {
+    *a = *b;
+    return;
+  }
+  delta = b->mean - a->mean;
+  delta2 = delta * delta;
+  nab = na * nb;
+  a->m4 += b->m4 + delta2 * delta2 * nab * (na * na - nab + nb * nb) /
+    (n * n * n) + 6.0 * delta2 * (na * na * b->m2 + nb * nb * a->m2) /
+    (n * n) + 4.0 * delta * (na * b->m3 - nb * a->m3) / n;
+  a->m3 += b->m3 + delta * delta2 * nab * (na - nb) / (n * n) +
+    3.0 * delta * (na * b->m2 - nb * a->m2) / n;
+  a->m2 += b->m2 + delta2 * nab / n;
+  a->mean += delta * nb / n;
+  a->n = n;
+  if (b->min < a->min)
+    a->min = b->min;
+  if (b->max > a->max)
+    a->max = b->max;
+}
+
+double stat_accumMean (StatAccum *a) {
+  /**
+     @param[in] a - an accumulator
+     @return the mean of the values added
+  */
+  if (a->n == 0.0)
+    die ("stat_accumMean: No observations");
+  return a->mean;
+}
+
+double stat_accumVariance (StatAccum *a) {
+  /**
+     @param[in] a - an accumulator
+     @return the variance of the values added, as in stat_variance()
+  */
+  if (a->n == 0.0)
+    die ("stat_accumVariance: No observations");
+  if (a->n == 1.0)
+    return 0.0;
+  return a->m2 / (a->n - 1.0);
+}
+
+double stat_accumStddev (StatAccum *a) {
+  /**
+     @param[in] a - an accumulator
+     @return the standard deviation of the values added, as in stat_stddev()
+  */
+  return sqrt (stat_accumVariance (a));
+}
+
+double stat_accumSkew (StatAccum *a) {
+  /**
+     @param[in] a - an accumulator
+     @return the skew of the values added, as in stat_skew();
+             STAT_INVALID if less than 3 values or all equal
+  */
+  double n = a->n;
+  double s;
+
+  if (n < 3.0 || a->m2 == 0.0)
+    return STAT_INVALID;
+  s = sqrt (a->m2 / (n - 1.0));
+  return n * a->m3 / ((n - 1.0) * (n - 2.0) * s * s * s);
+}
+
+double stat_accumKurt (StatAccum *a) {
+  /**
+     @param[in] a - an accumulator
+     @return the kurtosis of the values added, as in stat_kurt();
+             STAT_INVALID if less than 4 values or all equal
+  */
+  double n = a->n;
+  double var;
+
+  if (n < 4.0 || a->m2 == 0.0)
+    return STAT_INVALID;
+  var = a->m2 / (n - 1.0);
+  return n * (n + 1.0) * a->m4 /
+    ((n - 1.0) * (n - 2.0) * (n - 3.0) * var * var) -
+    3.0 * (n - 1.0) * (n - 1.0) / ((n - 2.0) * (n - 3.0));
+}
+
+double stat_accumMin (StatAccum *a) {
+  /**
+     @param[in] a - an accumulator
+     @return the smallest value added
+  */
+  if (a->n == 0.0)
+    die ("stat_accumMin: No observations");
+  return a->min;
+}
+
+double stat_accumMax (StatAccum *a) {
+  /**
+     @param[in] a - an accumulator
+     @return the largest value added
+  */
+  if (a->n == 0.0)
+    die ("stat_accumMax: No observations");
+  return a->max;
+}
+
 double stat_phi (double x) {
   /**
      Phi function. This function computes the value of the normal c.d.f. at
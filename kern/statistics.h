@@ -36,6 +36,13 @@ extern double stat_mean (double x[],int num);
 extern double stat_median (double x[],int num);
 extern double stat_median_quart (double x[],int num,double *q25,double *q75);
 extern double stat_median_abs_dev (double x[],int num);
+extern void stat_orderStats (double x[],int num,int ranks[],int numRanks,
+                             double values[],Array scratch);
+extern double stat_medianP (double x[],int num,Array scratch);
+extern double stat_median_quartP (double x[],int num,double *q25,double *q75,
+                                  Array scratch);
+extern double stat_median_abs_devP (double x[],int num,Array scratch);
+extern double stat_percentileP (double x[],int num,double p,Array scratch);
 extern double stat_variance (double x[],int num);
 extern double stat_stddev (double x[],int num);
 extern double stat_skew (double x[],int num);
@@ -88,6 +95,112 @@ extern void stat_qq_fixed (double **x,int n,int dim,double *values);
 
 extern double stat_gini (double x[],int num);
 
+/// stat_matrixSummary(): statistics per row
+#define STAT_ROWS 0
+/// stat_matrixSummary(): statistics per column
+#define STAT_COLS 1
+
+/// stat_matrixSummary() flag: mean
+#define STAT_SUMMARY_MEAN 1
+/// stat_matrixSummary() flag: variance as in stat_variance()
+#define STAT_SUMMARY_VARIANCE 2
+/// stat_matrixSummary() flag: standard deviation as in stat_stddev()
+#define STAT_SUMMARY_STDDEV 4
+/// stat_matrixSummary() flag: median as in stat_median()
+#define STAT_SUMMARY_MEDIAN 8
+/// stat_matrixSummary() flag: median absolute deviation as in stat_median_abs_dev()
+#define STAT_SUMMARY_MAD 16
+/// stat_matrixSummary() flag: skew as in stat_skew()
+#define STAT_SUMMARY_SKEW 32
+/// stat_matrixSummary() flag: kurtosis as in stat_kurt()
+#define STAT_SUMMARY_KURT 64
+/// stat_matrixSummary() flag: minimum
+#define STAT_SUMMARY_MIN 128
+/// stat_matrixSummary() flag: maximum
+#define STAT_SUMMARY_MAX 256
+
+/**
+   Results of stat_matrixSummary(): for each statistic requested an
+   array with one value per row or column, allocated by the caller;
+   the others are not used and may be NULL
+*/
+typedef struct {
+  double *mean; //!< STAT_SUMMARY_MEAN
+  double *variance; //!< STAT_SUMMARY_VARIANCE
+  double *stddev; //!< STAT_SUMMARY_STDDEV
+  double *median; //!< STAT_SUMMARY_MEDIAN
+  double *mad; //!< STAT_SUMMARY_MAD
+  double *skew; //!< STAT_SUMMARY_SKEW, STAT_INVALID if undefined
+  double *kurt; //!< STAT_SUMMARY_KURT, STAT_INVALID if undefined
+  double *min; //!< STAT_SUMMARY_MIN
+  double *max; //!< STAT_SUMMARY_MAX
+}StatSummary;
+
+extern void stat_matrixSummary (double **m,int nr,int nc,int axis,int flags,
+                                StatSummary *out);
+
+/**
+   Accumulator for the moments of a stream of values, see stat_accumAdd();
+   accumulators of parts of the data can be combined with stat_accumMerge()
+*/
+typedef struct {
+  double n; //!< number of values, a double to allow huge streams
+  double mean; //!< mean of the values
+  double m2; //!< sum of the squared deviations from the mean
+  double m3; //!< sum of the cubed deviations from the mean
+  double m4; //!< sum of the deviations from the mean to the 4th power
+  double min; //!< smallest value
+  double max; //!< largest value
+}StatAccum;
+
+extern void stat_accumInit (StatAccum *a);
+extern void stat_accumAdd (StatAccum *a,double x);
+extern void stat_accumAddValues (StatAccum *a,double x[],int num);
+extern void stat_accumMerge (StatAccum *a,StatAccum *b);
+extern double stat_accumMean (StatAccum *a);
+extern double stat_accumVariance (StatAccum *a);
+extern double stat_accumStddev (StatAccum *a);
+extern double stat_accumSkew (StatAccum *a);
+extern double stat_accumKurt (StatAccum *a);
+extern double stat_accumMin (StatAccum *a);
+extern double stat_accumMax (StatAccum *a);
+
+/**
+   The StatSketch object, a t-digest summarizing the distribution of a
+   stream of values in bounded memory, see stat_sketchCreate().
+   The members of this struct are PRIVATE for the statistics module -
+   DO NOT access from outside the statistics module
+*/
+typedef struct _statSketchStruct_ {
+  double compression; //!< accuracy parameter, see stat_sketchCreate()
+  int maxCentroids; //!< upper bound of centroids after compression
+  int room; //!< number of elements of mean and weight
+  int num; //!< centroids, then values not yet compressed
+  int numCompressed; //!< the first numCompressed are centroids in order
+  double total; //!< sum of all weights
+  double min; //!< smallest value added
+  double max; //!< largest value added
+  double *mean; //!< mean of each centroid
+  double *weight; //!< number of values of each centroid
+  double *tmpMean; //!< work space for compression
+  double *tmpWeight; //!< work space for compression
+  int *order; //!< work space for compression
+  Array work; //!< work space for compression
+}*StatSketch;
+
+extern StatSketch stat_sketchCreate (double compression);
+extern void stat_sketchDestroyFunc (StatSketch this1); /* do not use this function */
+/// destroy a sketch; use this macro, not stat_sketchDestroyFunc()
+#define stat_sketchDestroy(this1) ((this1) ? stat_sketchDestroyFunc(this1),this1=NULL,1:0)
+extern void stat_sketchAdd (StatSketch this1,double x);
+extern void stat_sketchAddValues (StatSketch this1,double x[],int num);
+extern void stat_sketchMerge (StatSketch this1,StatSketch other);
+extern double stat_sketchCount (StatSketch this1);
+extern double stat_sketchQuantile (StatSketch this1,double q);
+extern double stat_sketchPercentile (StatSketch this1,double p);
+extern void stat_sketchSerialize (StatSketch this1,Array bytes);
+extern StatSketch stat_sketchDeserialize (char *bytes,int len);
+
 extern double stat_phi (double x);
 extern double stat_phiQuantile (double beta);
 extern double stat_studentTQuantile (double beta,int k);
@@ -35,12 +35,19 @@
             complexity). Therefore StringPair/Map/MapIter are provided
             for the frequent case of strings mapped to strings.
 
-            Possible expansions for StringMap:
-            - the current list is unsorted, allows duplicates and is only
-              sequentially searched.
-            - possibly add stringlistInsert()/stringlistFind() methods for
-              operating
-            StringMap in sorted mode.
+            The StringMap list is unsorted and allows duplicates. Once it
+            has STRINGMAP_INDEXMIN pairs, stringmapGet() builds a hash
+            index over the names, so that repeated lookups are O(1)
+            instead of a linear scan. A StringMap is a plain Array, so
+            this module keeps the indices in a table of its own, by
+            StringMap; stringmapAdd() updates the index, stringmapClear()
+            and stringmapDestroy() drop it. A StringMap must therefore be
+            freed with stringmapDestroy(), which also frees its pairs.
+            The index never follows a pair pointer it has not checked
+            against the Array, and it is rebuilt when it finds that the
+            Array was changed directly (pairs added, removed, moved).
+            Only a pair replaced in place by one with another name may
+            stay unnoticed; call stringmapClearIndex() after doing that.
 
             For more documentation see file stringlist.txt .
 */
@@ -68,7 +75,20 @@ if (sl_add (sl,"a"))
 else
   ... existing
 
-Example 3 (StringMap)
+Example 3 (StringList, many strings)
+sl_add() keeps the list sorted on every new string, which gets slow
+for a million of them; collect them unsorted and sort once instead,
+and look them up through a hash index:
+StringList sl = sl_create (1000000);
+sl_bulkBegin (sl);
+while (...)
+  sl_addP (sl,probeName,probe);
+sl_bulkEnd (sl);
+sl_indexOn (sl,NULL);
+if (sl_get (sl,"1007_s_at"))
+  ...
+
+Example 4 (StringMap)
 what can not be done *elegantly* with StringList
 is to associate a string with *one* data element (currently
 it is always an array of pointers).
@@ -90,13 +110,50 @@ int main (int argc,char *argv[]) {
 }
 */
 
+#include "plabla.h"
+#ifdef PLABLA_HAVE_PTHREAD
+#include <pthread.h>
+#endif
 #include "log.h"
 #include "format.h"
 #include "hlrmisc.h"
+#include "hash.h"
+#include "arena.h"
+#include "ohtable.h"
 #include "stringlist.h"
 
 /* ------------ part 1: StringPair, StringMap, StringMapIter --------------- */
 
+/// number of pairs from which on stringmapGet() uses a hash index
+#define STRINGMAP_INDEXMIN 16
+
+/// the hash index of a StringMap
+typedef struct StringMapIndexStruct {
+  StringMap map; //!< the StringMap indexed
+  OhTable table; //!< of StringMapIndexEntry, the last pair added for each name
+  Arena arena; //!< holds the entries
+  int numPairs; //!< arrayMax() of the StringMap when the index was updated
+  char *base; //!< base of the StringMap when the index was updated
+  int stale; //!< set when an entry does not match the StringMap any more
+}*StringMapIndex;
+
+/// a pair in the hash index, or the key of a lookup
+typedef struct {
+  StringPair sp; //!< the pair at position pos when indexed; NULL for a key
+  char *name; //!< the name looked up; only for a key
+  unsigned int hash; //!< hash of the name
+  int pos; //!< position of sp in the StringMap
+  StringMapIndex smi; //!< the index
+}StringMapIndexEntry;
+
+/// the StringMapIndex of each StringMap that has one; NULL if none has
+static OhTable gIndices = NULL;
+
+#ifdef PLABLA_HAVE_PTHREAD
+/// protects gIndices, which StringMaps of all threads share
+static pthread_mutex_t gIndicesLock = PTHREAD_MUTEX_INITIALIZER;
+#endif
+
 StringPair stringpairCreate (char *name,char *value) {
   /**
      Both name and value are copied into the new StringPair object,
@@ -122,11 +179,188 @@ void stringpairDestroyFunc (StringPair this1) {
   hlr_free (this1);
 }
 
+static unsigned int stringmapEntryHash (StringMapIndexEntry *e) {
+  return e->hash;
+}
+
+static char *stringmapEntryName (StringMapIndexEntry *e) {
+  /**
+     @return the name of the pair of an entry; NULL if the StringMap
+             does not hold that pair at that position any more, i.e.
+             it was changed directly; the pair may then have been freed
+  */
+  StringMap m = e->smi->map;
+
+  if (e->sp == NULL)
+    return e->name;
+  if (e->pos < arrayMax (m) && arru (m,e->pos,StringPair) == e->sp)
+    return e->sp->name;
+  e->smi->stale = 1;
+  return NULL;
+}
+
+static int stringmapEntryOrder (StringMapIndexEntry *e1,
+                                StringMapIndexEntry *e2) {
+  char *n1,*n2;
+
+  if (e1->hash != e2->hash)
+    return 1;
+  if ((n1 = stringmapEntryName (e1)) == NULL ||
+      (n2 = stringmapEntryName (e2)) == NULL)
+    return 1;
+  return strcmp (n1,n2);
+}
+
+static unsigned int stringmapIndexHash (StringMapIndex smi) {
+  return (unsigned int)hash_int64 ((uint64_t)(size_t)smi->map);
+}
+
+static int stringmapIndexOrder (StringMapIndex smi1,StringMapIndex smi2) {
+  return smi1->map != smi2->map;
+}
+
+static void stringmapIndicesLock (void) {
+#ifdef PLABLA_HAVE_PTHREAD
+  pthread_mutex_lock (&gIndicesLock);
+#endif
+}
+
+static void stringmapIndicesUnlock (void) {
+#ifdef PLABLA_HAVE_PTHREAD
+  pthread_mutex_unlock (&gIndicesLock);
+#endif
+}
+
+static StringMapIndex stringmapIndexOf (StringMap this1) {
+  // returns the index of this1, NULL if it has none
+  struct StringMapIndexStruct key; // only map is looked at
+  void *found = NULL;
+
+  key.map = this1;
+  stringmapIndicesLock ();
+  if (gIndices == NULL || !oht_tableFind (gIndices,&key,&found))
+    found = NULL;
+  stringmapIndicesUnlock ();
+  return (StringMapIndex)found;
+}
+
+static void stringmapIndexRegister (StringMapIndex smi) {
+  // makes smi the index of smi->map, which has none
+  stringmapIndicesLock ();
+  if (gIndices == NULL)
+    gIndices = oht_tableCreate (0,(unsigned int (*)(void *))stringmapIndexHash,
+                                (int (*)(void *,void *))stringmapIndexOrder,
+                                NULL);
+  oht_tableInsert (gIndices,smi,NULL);
+  stringmapIndicesUnlock ();
+}
+
+static void stringmapIndexDestroy (StringMapIndex smi) {
+  // removes smi from the indices and frees it
+  stringmapIndicesLock ();
+  oht_tableDelete (gIndices,smi);
+  if (oht_tableNumElem (gIndices) == 0)
+    oht_tableDestroy (gIndices);
+  stringmapIndicesUnlock ();
+  oht_tableDestroy (smi->table);
+  arena_destroy (smi->arena);
+  hlr_free (smi);
+}
+
+static int stringmapIndexValid (StringMap this1,StringMapIndex smi) {
+  /**
+     @return 1 if smi, the index of this1 or NULL, exists and no direct
+             change of the StringMap was noticed since it was updated
+  */
+  return smi != NULL && !smi->stale && smi->numPairs == arrayMax (this1) &&
+    smi->base == this1->base;
+}
+
+static void stringmapIndexAdd (StringMapIndex smi,int pos) {
+  // adds the pair at position pos of the StringMap, which must be there;
+  // the pair added last wins, as in the linear search of stringmapGet()
+  StringMapIndexEntry *e = (StringMapIndexEntry *)
+    arena_alloc (smi->arena,sizeof (StringMapIndexEntry));
+
+  e->sp = arru (smi->map,pos,StringPair);
+  e->name = NULL;
+  e->hash = (unsigned int)hash_string (e->sp->name);
+  e->pos = pos;
+  e->smi = smi;
+  if (!oht_tableInsert (smi->table,e,NULL)) {
+    oht_tableDelete (smi->table,e);
+    oht_tableInsert (smi->table,e,NULL);
+  }
+  smi->numPairs = arrayMax (smi->map);
+  smi->base = smi->map->base;
+}
+
+static StringMapIndex stringmapIndex (StringMap this1) {
+  // returns the index of this1, building it if needed
+  StringMapIndex smi = stringmapIndexOf (this1);
+  int i;
+
+  if (stringmapIndexValid (this1,smi))
+    return smi;
+  if (smi != NULL)
+    stringmapIndexDestroy (smi);
+  smi = (StringMapIndex)hlr_malloc (sizeof (*smi));
+  smi->map = this1;
+  smi->table = oht_tableCreate (arrayMax (this1),
+                                (unsigned int (*)(void *))stringmapEntryHash,
+                                (int (*)(void *,void *))stringmapEntryOrder,
+                                NULL);
+  smi->arena = arena_create (0);
+  smi->stale = 0;
+  for (i=0;i<arrayMax (this1);i++)
+    stringmapIndexAdd (smi,i);
+  stringmapIndexRegister (smi);
+  return smi;
+}
+
+static StringPair stringmapIndexFind (StringMap this1,char *name) {
+  /**
+     Looks up name in the index of this1; if an entry turns out not to
+     match the StringMap any more, the index is rebuilt and the lookup
+     repeated
+  */
+  StringMapIndexEntry key;
+  StringMapIndex smi;
+  void *found;
+  int ok;
+
+  key.sp = NULL;
+  key.name = name;
+  key.hash = (unsigned int)hash_string (name);
+  for (;;) {
+    smi = stringmapIndex (this1);
+    key.smi = smi;
+    ok = oht_tableFind (smi->table,&key,&found);
+    if (!smi->stale)
+      return ok ? ((StringMapIndexEntry *)found)->sp : NULL;
+  }
+}
+
+void stringmapClearIndex (StringMap this1) {
+  /**
+     Drops the hash index of this1, if any; the index is rebuilt on
+     demand. Most direct changes of the StringMap Array are noticed
+     by the index itself; call this after replacing a StringPair in
+     place by one with a different name.
+     @param[in] this1 - created by stringmapCreate()
+  */
+  StringMapIndex smi = stringmapIndexOf (this1);
+
+  if (smi != NULL)
+    stringmapIndexDestroy (smi);
+}
+
 void stringmapClear (StringMap this1) {
   /**
      @param[in] this1 - created by stringmapCreate()
   */
   int i = arrayMax (this1);
+  stringmapClearIndex (this1);
   while (i--)
     stringpairDestroy (arru (this1,i,StringPair));
   arraySetMax (this1,0);
@@ -144,22 +378,28 @@ void stringmapDestroyFunc (StringMap this1) {
 StringPair stringmapAdd (StringMap this1,char *name,char *value) {
   /**
      Add 'name'/'value' to this1 StringMap.<br>
-     Postcondition: stringmapGetValue(this1, name) will return value,
-                    if this was the first occurence of name;<br>
+     Postcondition: stringmapGetValue(this1, name) will return value;<br>
                     Adding the same name multiple times (possibly
                     with different values) is possible
      @param[in] this1 - the StringMap
      @param[in] name,value - exactly as in stringpairCreate()
   */
   StringPair sp = stringpairCreate (name,value);
+  StringMapIndex smi = stringmapIndexOf (this1);
+  int valid = stringmapIndexValid (this1,smi);
+
   array (this1,arrayMax (this1),StringPair) = sp;
+  if (valid)
+    stringmapIndexAdd (smi,arrayMax (this1) - 1);
+  else if (smi != NULL)
+    stringmapIndexDestroy (smi); // changed directly, rebuild when needed
   return sp;
 }
 
 StringPair stringmapGet (StringMap this1,char *name) {
   /**
-     Get the first occurence of 'name' in this1 StringMap.
-     If there are multiple occurences, return the first one.
+     Get the occurence of 'name' in this1 StringMap.
+     If there are multiple occurences, return the one added last.
      @param[in] this1 - the StringMap
      @param[in] name
      @return StringPair if found, else NULL.<br>
@@ -167,6 +407,9 @@ StringPair stringmapGet (StringMap this1,char *name) {
              and must not be freed by the caller
   */
   int i = arrayMax (this1);
+
+  if (i >= STRINGMAP_INDEXMIN)
+    return stringmapIndexFind (this1,name);
   while (i--)
     if (strEqual (arru (this1,i,StringPair)->name,name))
       return arru (this1,i,StringPair);
@@ -240,6 +483,10 @@ StringList sl_createG (int initialSize,int byReference,SLELEMORDERF (orderF)) {
   this1->orderF = orderF ? orderF : stringElemOrder;
   this1->pIterElemI = -1;
   this1->pIterPlI = -1;
+  this1->bulkMode = 0;
+  this1->index = NULL;
+  this1->indexValid = 0;
+  this1->indexMisses = 0;
   return this1;
 }
 
@@ -267,6 +514,7 @@ void sl_clear (StringList this1) {
   this1->hasPointers = 0;
   this1->pIterElemI = -1;
   this1->pIterPlI = -1;
+  this1->indexValid = 0;
 }
 
 void sl_destroy_func (StringList this1) {
@@ -277,9 +525,37 @@ void sl_destroy_func (StringList this1) {
     return;
   sl_clear (this1);
   arrayDestroy (this1->sl);
+  sl_indexOff (this1);
   hlr_free (this1);
 }
 
+static void sl_indexBuild (StringList this1);
+
+static int sl_find (StringList this1,char *s,int *ip) {
+  // binary search or, if there is a valid index, hash lookup
+  StringListElem e;
+  void *found;
+
+  if (this1->bulkMode)
+    die ("StringList lookup during bulk load, call sl_bulkEnd() first");
+  e.s = s;
+  e.pl = NULL;
+  if (this1->index != NULL) {
+    // rebuild only after enough lookups to pay for it
+    if (!this1->indexValid &&
+        ++this1->indexMisses > arrayMax (this1->sl) / 8)
+      sl_indexBuild (this1);
+    if (this1->indexValid) {
+      if (!oht_tableFind ((OhTable)this1->index,&e,&found))
+        return 0;
+      if (ip != NULL)
+        *ip = (StringListElem *)found - arrp (this1->sl,0,StringListElem);
+      return 1;
+    }
+  }
+  return arrayFind (this1->sl,&e,ip,(ARRAYORDERF)this1->orderF);
+}
+
 int sl_addP (StringList this1,char *s,void *p) {
   /**
      Add string 's' and its accompanying pointer 'p' to 'this1' StringList
@@ -291,18 +567,33 @@ int sl_addP (StringList this1,char *s,void *p) {
                  after sl_add()
      @param[in] p pointer to additional data describing 's' or NULL if none;
      @param[out] this1 - with 's' (and 'p') added
-     @return 1 if added, 0 if not added because already present
+     @return 1 if added, 0 if not added because already present;
+             always 1 between sl_bulkBegin() and sl_bulkEnd()
   */
   StringListElem e;
   StringListElem *ep;
   int i;
   int isNewElem;
-  e.s = s;
-  e.pl = NULL;
-  isNewElem = arrayFindInsert (this1->sl,&e,&i,(ARRAYORDERF)this1->orderF);
-  ep = arrp (this1->sl,i,StringListElem);
-  if (isNewElem && !this1->byReference)
-    ep->s = hlr_strdup (s);
+
+  if (this1->bulkMode) {
+    ep = arrayp (this1->sl,arrayMax (this1->sl),StringListElem);
+    ep->s = this1->byReference ? s : hlr_strdup (s);
+    ep->pl = NULL;
+    isNewElem = 1;
+  }
+  else {
+    if (this1->indexValid && sl_find (this1,s,&i))
+      isNewElem = 0;
+    else {
+      e.s = s;
+      e.pl = NULL;
+      isNewElem = arrayFindInsert (this1->sl,&e,&i,(ARRAYORDERF)this1->orderF);
+      this1->indexValid = 0;
+    }
+    ep = arrp (this1->sl,i,StringListElem);
+    if (isNewElem && !this1->byReference)
+      ep->s = hlr_strdup (s);
+  }
   if (p != NULL) {
     if (ep->pl == NULL) {
       ep->pl = arrayCreate (this1->cardinality,void*);
@@ -351,10 +642,8 @@ int sl_pIterInit (StringList this1,char *s) {
      @param[in] s -- search string
      @return 1 if ok; 0 if search string not found in StringList
   */
-  StringListElem e;
   int i;
-  e.s = s;
-  if (arrayFind (this1->sl,&e,&i,(ARRAYORDERF)this1->orderF)) {
+  if (sl_find (this1,s,&i)) {
     this1->pIterElemI = i;
     this1->pIterPlI = 0;
     return 1;
@@ -391,11 +680,9 @@ void *sl_getFirstP (StringList this1,char *s) {
                      NULL if 's' not found or
                      NULL if 's' found, but not associated with pointer
   */
-  StringListElem e;
   int i;
 
-  e.s = s;
-  if (arrayFind (this1->sl,&e,&i,(ARRAYORDERF)this1->orderF)) {
+  if (sl_find (this1,s,&i)) {
     StringListElem *ep;
     ep = arrp (this1->sl,i,StringListElem);
     if (ep->pl == NULL || arrayMax (ep->pl) == 0)
@@ -418,11 +705,9 @@ int sl_getP (StringList this1,char *s,int *ip,Array *pl /* of void* */) {
      @param[out] ip - internal index of element found; can be used
                       in sl_getStrI(); only changed if 1 returned
   */
-  StringListElem e;
   int i;
 
-  e.s = s;
-  if (arrayFind (this1->sl,&e,&i,(ARRAYORDERF)this1->orderF)) {
+  if (sl_find (this1,s,&i)) {
     if (pl != NULL)
       *pl = arrp (this1->sl,i,StringListElem)->pl;
     if (ip != NULL)
@@ -449,6 +734,146 @@ void sl_ref2val (StringList this1) {
   this1->byReference = 0;
 }
 
+void sl_bulkBegin (StringList this1) {
+  /**
+     Start adding many strings: until sl_bulkEnd() sl_addP() only appends
+     to the list, which makes adding n strings O(n log n) instead of
+     O(n^2). Lookups are not possible in between.
+     @param[in] this1 - created by sl_create() / sl_createG()
+  */
+  if (this1->bulkMode)
+    die ("sl_bulkBegin() called twice");
+  this1->bulkMode = 1;
+}
+
+static void sl_mergeSort (StringListElem *a,StringListElem *tmp,int n,
+                          SLELEMORDERF (orderF)) {
+  // stable, so pointers of equal strings stay in the order they were added
+  StringListElem e;
+  int i,j,k,m;
+
+  if (n <= 16) {
+    for (i=1;i<n;i++) {
+      e = a[i];
+      for (j=i;j>0 && orderF (&a[j-1],&e) > 0;j--)
+        a[j] = a[j-1];
+      a[j] = e;
+    }
+    return;
+  }
+  m = n / 2;
+  sl_mergeSort (a,tmp,m,orderF);
+  sl_mergeSort (a + m,tmp,n - m,orderF);
+  if (orderF (&a[m-1],&a[m]) <= 0)
+    return;
+  memcpy (tmp,a,m * sizeof (StringListElem));
+  i = 0;
+  j = m;
+  k = 0;
+  while (i < m && j < n)
+    a[k++] = orderF (&a[j],&tmp[i]) < 0 ? a[j++] : tmp[i++];
+  while (i < m)
+    a[k++] = tmp[i++];
+}
+
+int sl_bulkEnd (StringList this1) {
+  /**
+     Finish adding strings after sl_bulkBegin(): sorts the list and
+     merges equal strings; their pointers are kept in the order added.
+     @param[in] this1 - StringList after sl_bulkBegin()
+     @return number of strings in the list, sl_count(this1)
+  */
+  StringListElem *a,*keep,*ep;
+  StringListElem *tmp;
+  int n = arrayMax (this1->sl);
+  int i,j,k;
+
+  if (!this1->bulkMode)
+    die ("sl_bulkEnd() without sl_bulkBegin()");
+  this1->bulkMode = 0;
+  this1->indexValid = 0;
+  if (n == 0)
+    return 0;
+  a = arrp (this1->sl,0,StringListElem);
+  tmp = (StringListElem *)hlr_malloc ((n / 2 + 1) * sizeof (StringListElem));
+  sl_mergeSort (a,tmp,n,this1->orderF);
+  hlr_free (tmp);
+  j = 0;
+  for (i=1;i<n;i++) {
+    ep = &a[i];
+    keep = &a[j];
+    if (this1->orderF (keep,ep) != 0) {
+      a[++j] = *ep;
+      continue;
+    }
+    if (ep->pl != NULL) {
+      if (keep->pl == NULL)
+        keep->pl = ep->pl;
+      else {
+        for (k=0;k<arrayMax (ep->pl);k++)
+          array (keep->pl,arrayMax (keep->pl),void*) = arru (ep->pl,k,void*);
+        arrayDestroy (ep->pl);
+      }
+    }
+    if (!this1->byReference)
+      hlr_free (ep->s);
+  }
+  arraySetMax (this1->sl,j + 1);
+  return j + 1;
+}
+
+static unsigned int stringElemHash (StringListElem *e) {
+  return (unsigned int)hash_string (e->s);
+}
+
+static void sl_indexBuild (StringList this1) {
+  OhTable index = (OhTable)this1->index;
+  unsigned int (*hashF)(void *) = index->hashFunction;
+  int i;
+
+  oht_tableDestroy (index);
+  index = oht_tableCreate (arrayMax (this1->sl),hashF,
+                           (int (*)(void *,void *))this1->orderF,NULL);
+  for (i=0;i<arrayMax (this1->sl);i++)
+    oht_tableInsert (index,arrp (this1->sl,i,StringListElem),NULL);
+  this1->index = index;
+  this1->indexValid = 1;
+  this1->indexMisses = 0;
+}
+
+void sl_indexOn (StringList this1,unsigned int (*hashF)(StringListElem *)) {
+  /**
+     Give 'this1' a hash index, making sl_getP(), sl_get(), sl_getFirstP(),
+     sl_pIterInit() and adding strings already present O(1) instead of
+     O(log n). The index is rebuilt lazily after new strings were added.
+     @param[in] this1 - created by sl_create() / sl_createG()
+     @param[in] hashF - hash function consistent with the ordering function
+                        of 'this1', i.e. equal strings have equal hashes;
+                        NULL for the default case-sensitive order
+  */
+  if (hashF == NULL) {
+    if (this1->orderF != stringElemOrder)
+      die ("sl_indexOn() needs a hash function for this ordering function");
+    hashF = stringElemHash;
+  }
+  sl_indexOff (this1);
+  this1->index = oht_tableCreate (0,(unsigned int (*)(void *))hashF,
+                                  (int (*)(void *,void *))this1->orderF,NULL);
+  if (!this1->bulkMode)
+    sl_indexBuild (this1);
+}
+
+void sl_indexOff (StringList this1) {
+  /**
+     Remove the hash index from 'this1', if any
+     @param[in] this1 - created by sl_create() / sl_createG()
+  */
+  OhTable index = (OhTable)this1->index;
+  oht_tableDestroy (index);
+  this1->index = NULL;
+  this1->indexValid = 0;
+}
+
 StringList sl_union (StringList sl1,StringList sl2) {
   /**
      Determine union of two StringLists
@@ -465,6 +890,8 @@ StringList sl_union (StringList sl1,StringList sl2) {
     die ("sl_union() cannot handle StringLists with pointers");
   if (sl1->orderF != sl2->orderF)
     die ("sl_union() cannot handle StringLists with different ordering functions");
+  if (sl1->bulkMode || sl2->bulkMode)
+    die ("sl_union() cannot handle StringLists in bulk load");
   if (arrayMax (sl2->sl) > arrayMax (sl1->sl)) {
     bigList = sl2;
     smallList = sl1;
@@ -498,6 +925,8 @@ StringList sl_intersect (StringList sl1,StringList sl2) {
     die ("sl_intersect() cannot handle StringLists with pointers");
   if (sl1->orderF != sl2->orderF)
     die ("sl_intersect() cannot handle StringLists with different ordering functions");
+  if (sl1->bulkMode || sl2->bulkMode)
+    die ("sl_intersect() cannot handle StringLists in bulk load");
   if (arrayMax (sl2->sl) > arrayMax (sl1->sl)) {
     bigList = sl2;
     smallList = sl1;
@@ -527,6 +956,8 @@ StringList sl_diff (StringList sl1,StringList sl2) {
     die ("sl_diff() cannot handle StringLists with pointers");
   if (sl1->orderF != sl2->orderF)
     die ("sl_diff() cannot handle StringLists with different ordering functions");
+  if (sl1->bulkMode || sl2->bulkMode)
+    die ("sl_diff() cannot handle StringLists in bulk load");
   e.pl = NULL;
   result = sl_createG (arrayMax (sl1->sl),0,sl1->orderF);
   for (i=0;i<arrayMax (sl1->sl);i++) {
@@ -50,6 +50,7 @@ extern void stringpairDestroyFunc (StringPair this1);
 #define StringMap Array
 
 extern void stringmapClear (StringMap this1);
+extern void stringmapClearIndex (StringMap this1);
 
 /// convenience
 #define stringmapCreate(initialSize) arrayCreate(initialSize,StringPair)
@@ -103,6 +104,10 @@ typedef struct StringListStruct {
   SLELEMORDERF (orderF); //!< pointer to ordering function
   int pIterElemI; //!< index of StringElem in current pIter, -1 if not active
   int pIterPlI; //!< index within 'pl' of current StringElem in pIter, -1 if not active
+  int bulkMode; //!< 1 between sl_bulkBegin() and sl_bulkEnd(): 'sl' is unsorted
+  void *index; //!< NULL or OhTable of pointers into 'sl', see sl_indexOn()
+  int indexValid; //!< 0 if 'sl' changed since 'index' was built
+  int indexMisses; //!< lookups without 'index' since it became invalid
 }*StringList;
 
 extern StringList sl_createG (int initialSize,int byReference,
@@ -143,6 +148,12 @@ extern int sl_getP (StringList this1,char *s,int *ip,Array *pl /* of void* */);
 /// returns: 1 if 's' found in StringList 'this1', else 0
 #define sl_get(this1,s) sl_getP(this1,s,NULL,NULL)
 
+extern void sl_bulkBegin (StringList this1);
+extern int sl_bulkEnd (StringList this1);
+extern void sl_indexOn (StringList this1,
+                        unsigned int (*hashF)(StringListElem *));
+extern void sl_indexOff (StringList this1);
+
 // define SL_CHECK to enable range checking for StringList access
 #ifdef SL_CHECK
 char *sl_getStrIfunc (StringList this1,int i);
@@ -0,0 +1,1088 @@
+#include <math.h>
+#include <stdint.h>
+#include <unistd.h>
+#include <sys/wait.h>
+#include "plabla.h"
+#ifdef PLABLA_HAVE_PTHREAD
+#include <pthread.h>
+#endif
+#include "format.h"
+#include "log.h"
+#include "arg.h"
+#include "ohtable.h"
+#include "btree.h"
+#include "sstable.h"
+#include "intern.h"
+#include "hash.h"
+#include "linestream.h"
+#include "statistics.h"
+
+#define STARTUP_MSG "Consistency checks of kern modules"
+#define PROG_VERSION "DEV"
+#define AUTHOR_MAIL "roland.schmucki@roche.com"
+
+
+void usagef (int level)
+{
+  romsg ("\n"
+         "Program: %s \n\n"
+         "Version: %s \n\n"
+         "Notes:   %s \n\n"
+         "Usage:   %s [-n count] [-seed s]\n\n"
+         "Runs each module against a simple reference (a plain array,\n"
+         "a sorted copy, the direct formula) on random data and prints\n"
+         "one line per module. Exits with 1 if any check failed.\n"
+         "-n: number of values per check (100000)\n"
+         "-seed: seed of the random numbers (1)\n"
+         "\n\n"
+         "Report bugs and feedback to %s"
+         "\n\n",
+         arg_getProgName (),PROG_VERSION,STARTUP_MSG,arg_getProgName (),
+         AUTHOR_MAIL);
+}
+
+static int gFailures = 0; // failed checks of the current module
+
+#define CHECK(cond) ((cond) ? 1 : failure (__LINE__,#cond))
+
+static int failure (int line,char *cond)
+{
+  if (gFailures++ < 10)
+    printf ("  line %d: failed: %s\n",line,cond);
+  return 0;
+}
+
+static int report (char *what)
+{
+  /* prints the outcome of the checks of one module, returns 1 if ok */
+  int ok = gFailures == 0;
+
+  printf ("%-12s %s",what,ok ? "ok" : "FAILED");
+  if (!ok)
+    printf (" (%d checks)",gFailures);
+  printf ("\n");
+  gFailures = 0;
+  return ok;
+}
+
+static int dies (void (*f)(void *),void *arg)
+{
+  /* returns 1 if f(arg) stops the program with die(), which exits with
+     1, rather than returning or crashing; runs it in a child process */
+  pid_t pid;
+  int status;
+
+  fflush (NULL);
+  if ((pid = fork ()) < 0)
+    die ("fork failed");
+  if (pid == 0) {
+    freopen ("/dev/null","w",stderr); // the message of die() is expected
+    f (arg);
+    _exit (0);
+  }
+  if (waitpid (pid,&status,0) != pid)
+    die ("waitpid failed");
+  return WIFEXITED (status) && WEXITSTATUS (status) == 1;
+}
+
+/* ----------------------------- oht_ ----------------------------------- */
+
+static unsigned int hashInt (void *p)
+{
+  uint32_t x = *(int *)p;
+  x ^= x >> 16;
+  x *= 0x45d9f3b;
+  x ^= x >> 16;
+  return x;
+}
+
+static int orderInt (void *p1,void *p2)
+{
+  int a = *(int *)p1;
+  int b = *(int *)p2;
+  return a < b ? -1 : a > b;
+}
+
+static int checkOht (int n)
+{
+  /* random inserts and deletes of keys 0..n-1 against a presence array;
+     the table holds pointers into 'keys' */
+  int *keys = (int *)hlr_malloc (n * sizeof (int));
+  char *present = (char *)hlr_calloc (n,1);
+  OhTable t = oht_tableCreate (16,hashInt,orderInt,NULL);
+  OhIterator it;
+  void *found;
+  int *v;
+  int i,k,count = 0,seen = 0;
+
+  for (i=0;i<n;i++)
+    keys[i] = i;
+  for (i=0;i<4*n;i++) {
+    k = rand () % n;
+    if (rand () % 3 == 0) {
+      CHECK (oht_tableDelete (t,&keys[k]) == present[k]);
+      count -= present[k];
+      present[k] = 0;
+    }
+    else {
+      CHECK (oht_tableInsert (t,&keys[k],NULL) == !present[k]);
+      count += !present[k];
+      present[k] = 1;
+    }
+  }
+  CHECK (oht_tableNumElem (t) == count);
+  for (k=0;k<n;k++) {
+    i = k; // a different address than keys[k]
+    CHECK (oht_tableFind (t,&i,&found) == present[k]);
+    if (present[k])
+      CHECK (found == &keys[k]);
+  }
+  it = oht_itCreate (t);
+  while ((v = (int *)oht_itNextValue (it)) != NULL) {
+    CHECK (present[*v] == 1);
+    present[*v] = 2; // each value once
+    seen++;
+  }
+  oht_itDestroy (it);
+  CHECK (seen == count);
+  oht_tableDestroy (t);
+  hlr_free (present);
+  hlr_free (keys);
+  return report ("oht_");
+}
+
+/* ----------------------------- btree_ --------------------------------- */
+
+static void cleanNothing (void *p)
+{
+  /* the values belong to the caller */
+}
+
+static int checkBtree (int n)
+{
+  /* random inserts and deletes of keys 0..n-1 against a presence array,
+     then ordered access against a scan of the array */
+  int *keys = (int *)hlr_malloc (n * sizeof (int));
+  char *present = (char *)hlr_calloc (n,1);
+  BTree t = btree_treeCreate (orderInt,cleanNothing);
+  BTreeIterator it;
+  void *found;
+  int *v;
+  int i,k,f,count = 0,prev,next;
+
+  for (i=0;i<n;i++)
+    keys[i] = i;
+  for (i=0;i<4*n;i++) {
+    k = rand () % n;
+    if (rand () % 3 == 0) {
+      CHECK (btree_treeDelete (t,&keys[k]) == present[k]);
+      count -= present[k];
+      present[k] = 0;
+    }
+    else {
+      CHECK (btree_treeInsert (t,&keys[k],NULL) == !present[k]);
+      count += !present[k];
+      present[k] = 1;
+    }
+  }
+  CHECK (btree_treeIsConsistent (t));
+  CHECK (btree_treeNumValues (t) == count);
+  // in order, with predecessor and successor of each key
+  it = btree_itCreate (t);
+  prev = -1;
+  for (k=0;k<n;k++) {
+    CHECK (btree_treeFind (t,&keys[k],&found) == present[k]);
+    v = (int *)btree_treePrevValue (t,&keys[k],&f);
+    CHECK (f == present[k] && (v == NULL ? prev < 0 : *v == prev));
+    if (!present[k])
+      continue;
+    CHECK (found == &keys[k]);
+    CHECK ((v = (int *)btree_itNextValue (it)) != NULL && *v == k);
+    prev = k;
+  }
+  CHECK (btree_itNextValue (it) == NULL);
+  btree_itDestroy (it);
+  // reverse order, and range starts
+  it = btree_itCreateRev (t);
+  next = -1;
+  for (k=n-1;k>=0;k--) {
+    v = (int *)btree_treeNextValue (t,&keys[k],&f);
+    CHECK (f == present[k] && (v == NULL ? next < 0 : *v == next));
+    if (present[k]) {
+      CHECK ((v = (int *)btree_itPrevValue (it)) != NULL && *v == k);
+      next = k;
+    }
+  }
+  CHECK (btree_itPrevValue (it) == NULL);
+  btree_itDestroy (it);
+  for (i=0;i<100;i++) {
+    k = rand () % n;
+    it = btree_itCreateAt (t,&keys[k]);
+    v = (int *)btree_itNextValue (it);
+    while (k < n && !present[k])
+      k++;
+    CHECK (v == NULL ? k == n : *v == k);
+    btree_itDestroy (it);
+  }
+  btree_treeDestroy (t);
+  hlr_free (present);
+  hlr_free (keys);
+  return report ("btree_");
+}
+
+/* ----------------------------- sst_ ----------------------------------- */
+
+static void sstFindAll (void *arg)
+{
+  SsTable t = (SsTable)arg;
+  long i;
+
+  for (i=0;i<sst_count (t);i++)
+    sst_find (t,sst_key (t,i));
+}
+
+static void sstPatch (char *fn,long off,void *p,int len)
+{
+  /* overwrites len bytes at offset off of file fn */
+  FILE *fp;
+
+  if ((fp = fopen (fn,"r+b")) == NULL || fseek (fp,off,SEEK_SET) != 0 ||
+      fwrite (p,1,len,fp) != len || fclose (fp) != 0)
+    die ("%s: cannot patch",fn);
+}
+
+static void sstRead (char *fn,long off,void *p,int len)
+{
+  /* reads len bytes at offset off of file fn */
+  FILE *fp;
+
+  if ((fp = fopen (fn,"rb")) == NULL || fseek (fp,off,SEEK_SET) != 0 ||
+      fread (p,1,len,fp) != len)
+    die ("%s: cannot read",fn);
+  fclose (fp);
+}
+
+static void sstWriteKeys (char *fn,int n)
+{
+  /* writes keys key0..key<n-1> with their numbers as values */
+  SstWriter w = sst_writerCreate (fn,sizeof (int));
+  Stringa key = stringCreate (20);
+  int i;
+
+  for (i=0;i<n;i++) {
+    stringPrintf (key,"key%d",i);
+    sst_writerAdd (w,string (key),&i);
+  }
+  sst_writerClose (w);
+  stringDestroy (key);
+}
+
+static int checkSst (int n)
+{
+  /* writes keys in random order and reads them back; then damages copies
+     of the file: bad headers must be refused by sst_open(), bad key
+     offsets and slot entries must make lookups die() */
+  Stringa fn = stringCreate (40);
+  Stringa key = stringCreate (20);
+  SstWriter w;
+  SsTable t;
+  int *perm = (int *)hlr_malloc (n * sizeof (int));
+  int i,j,k;
+  long pos;
+  uint64_t off;
+  uint32_t slot[2];
+
+  stringPrintf (fn,"/tmp/kerncheck%d.sst",(int)getpid ());
+  for (i=0;i<n;i++)
+    perm[i] = i;
+  for (i=n-1;i>0;i--) {
+    j = rand () % (i + 1);
+    k = perm[i];
+    perm[i] = perm[j];
+    perm[j] = k;
+  }
+  w = sst_writerCreate (string (fn),sizeof (int));
+  for (i=0;i<n;i++) {
+    stringPrintf (key,"key%d",perm[i]);
+    sst_writerAdd (w,string (key),&perm[i]);
+  }
+  sst_writerClose (w);
+  if (CHECK ((t = sst_open (string (fn))) != NULL)) {
+    CHECK (sst_count (t) == n && sst_valueSize (t) == sizeof (int));
+    for (i=0;i<n;i++) {
+      stringPrintf (key,"key%d",i);
+      CHECK ((pos = sst_find (t,string (key))) >= 0 &&
+             strEqual (sst_key (t,pos),string (key)) &&
+             *(int *)sst_value (t,pos) == i);
+      CHECK (sst_lowerBound (t,string (key)) == pos);
+      stringCat (key,"\001"); // not a key, sorts right after key i
+      CHECK (sst_get (t,string (key)) == NULL);
+      CHECK (sst_lowerBound (t,string (key)) == pos + 1);
+    }
+    for (i=1;i<n;i++)
+      CHECK (strcmp (sst_key (t,i-1),sst_key (t,i)) < 0);
+    sst_close (t);
+  }
+  // bad magic, then a truncated file
+  sstPatch (string (fn),0,"BADSST",6);
+  CHECK (sst_open (string (fn)) == NULL);
+  CHECK (truncate (string (fn),100) == 0);
+  CHECK (sst_open (string (fn)) == NULL);
+  warnReset ();
+  // a key offset beyond the strings; the header fields offKeys and
+  // offSlots are at 40 and 56, see SstHeader in sstable.c
+  sstWriteKeys (string (fn),n);
+  sstRead (string (fn),40,&off,sizeof (off));
+  off += (n / 2) * sizeof (uint64_t);
+  sstPatch (string (fn),off,"\377\377\377\377",4);
+  if (CHECK ((t = sst_open (string (fn))) != NULL)) {
+    CHECK (dies (sstFindAll,t));
+    sst_close (t);
+  }
+  // a slot with a key number beyond the keys
+  sstWriteKeys (string (fn),n);
+  sstRead (string (fn),56,&off,sizeof (off));
+  do { // to the first slot in use
+    sstRead (string (fn),off,slot,sizeof (slot));
+    off += sizeof (slot);
+  } while (slot[1] == 0);
+  slot[1] = n + 1;
+  sstPatch (string (fn),off - sizeof (slot),slot,sizeof (slot));
+  if (CHECK ((t = sst_open (string (fn))) != NULL)) {
+    CHECK (dies (sstFindAll,t));
+    sst_close (t);
+  }
+  unlink (string (fn));
+  hlr_free (perm);
+  stringDestroy (key);
+  stringDestroy (fn);
+  return report ("sst_");
+}
+
+/* ----------------------------- intern_ -------------------------------- */
+
+static int checkIntern (int n)
+{
+  /* interns random strings of n/4 distinct ones against an array of the
+     first copy returned for each; then the interning tokenizers against
+     textStrtok() and textFieldtok() */
+  int m = n / 4;
+  char **first = (char **)hlr_calloc (m,sizeof (char *));
+  InternPool pool = intern_poolCreate (0);
+  Stringa s = stringCreate (20);
+  Texta t1,t2;
+  char *p,*q;
+  int i,k,count = 0,tok;
+
+  for (i=0;i<n;i++) {
+    k = rand () % m;
+    stringPrintf (s,"s%d",k);
+    CHECK (intern_find (pool,string (s)) == first[k]);
+    p = intern_string (pool,string (s));
+    CHECK (p != string (s) && strEqual (p,string (s)));
+    if (first[k] == NULL) {
+      first[k] = p;
+      count++;
+    }
+    CHECK (p == first[k]);
+  }
+  CHECK (intern_count (pool) == count);
+  for (i=0;i<100;i++) {
+    stringClear (s);
+    for (k=rand ()%8;k>0;k--)
+      stringAppendf (s,"%s%d",rand () % 3 ? "," : ",,",rand () % 4);
+    for (tok=0;tok<2;tok++) { // the tokenizers change their input
+      p = hlr_strdup (string (s));
+      q = hlr_strdup (string (s));
+      t1 = tok ? textFieldtok (q,",") : textStrtok (q,",");
+      t2 = tok ? textFieldtokInterned (pool,p,",") :
+        textStrtokInterned (pool,p,",");
+      if (CHECK (arrayMax (t1) == arrayMax (t2)))
+        for (k=0;k<arrayMax (t1);k++)
+          CHECK (strEqual (textItem (t1,k),textItem (t2,k)) &&
+                 intern_find (pool,textItem (t1,k)) == textItem (t2,k));
+      textDestroy (t1);
+      arrayDestroy (t2);
+      hlr_free (q);
+      hlr_free (p);
+    }
+  }
+  intern_poolDestroy (pool);
+  stringDestroy (s);
+  hlr_free (first);
+  return report ("intern_");
+}
+
+/* ----------------------------- hash_tableMT -------------------------- */
+
+#define MT_THREADS 4
+
+typedef struct {
+  int key; // first, so that hash_selectInt() applies
+  int count; // number of insertions of key
+}KeyCount;
+
+typedef struct {
+  HashTableMT table;
+  KeyCount *entries; // one per key, owned by this thread
+  int n; // number of keys
+  int t; // number of this thread, 0..MT_THREADS-1
+  int inserted; // number of new values
+  int deleted; // number of deleted values
+}MtJob;
+
+static int orderKeyCount (void *p1,void *p2)
+{
+  int a = ((KeyCount *)p1)->key;
+  int b = ((KeyCount *)p2)->key;
+  return a < b ? -1 : a > b;
+}
+
+static void addCount (void *old,void *new)
+{
+  ((KeyCount *)old)->count += ((KeyCount *)new)->count;
+}
+
+static void *mtInsert (void *arg)
+{
+  /* inserts the keys k of this thread (k % MT_THREADS == t) and the
+     first quarter of the keys, which all threads insert */
+  MtJob *job = (MtJob *)arg;
+  int k;
+
+  for (k=0;k<job->n;k++)
+    if (k % MT_THREADS == job->t || k < job->n / 4) {
+      job->entries[k].key = k;
+      job->entries[k].count = 1;
+      job->inserted += hash_tableMTInsert (job->table,&job->entries[k],
+                                           addCount);
+    }
+  return NULL;
+}
+
+static void *mtDelete (void *arg)
+{
+  /* deletes the keys of this thread */
+  MtJob *job = (MtJob *)arg;
+  KeyCount kc;
+
+  for (kc.key=job->t;kc.key<job->n;kc.key+=MT_THREADS)
+    job->deleted += hash_tableMTDelete (job->table,&kc);
+  return NULL;
+}
+
+static void mtRun (void *(*f)(void *),MtJob jobs[])
+{
+  /* runs f on each job, in a thread of its own if possible */
+  int t;
+#ifdef PLABLA_HAVE_PTHREAD
+  pthread_t threads[MT_THREADS];
+
+  for (t=0;t<MT_THREADS;t++)
+    if (pthread_create (&threads[t],NULL,f,&jobs[t]) != 0)
+      die ("pthread_create failed");
+  for (t=0;t<MT_THREADS;t++)
+    pthread_join (threads[t],NULL);
+#else
+  for (t=0;t<MT_THREADS;t++)
+    f (&jobs[t]);
+#endif
+}
+
+static int checkHashMT (int n)
+{
+  /* MT_THREADS threads insert disjoint and shared keys into a table of
+     many shards at once, counting duplicates in modifyDuplicate(); then
+     they delete all keys again. Compared against the known key set */
+  int allocCnt = hlr_getAllocCnt ();
+  MtJob jobs[MT_THREADS];
+  HashTableMT table;
+  KeyCount kc,*found;
+  int t,k,inserted = 0,deleted = 0,owned;
+
+  table = hash_tableMTCreate (64,-1,hash_selectInt,orderKeyCount,
+                              cleanNothing);
+  for (t=0;t<MT_THREADS;t++) {
+    jobs[t].table = table;
+    jobs[t].entries = (KeyCount *)hlr_calloc (n,sizeof (KeyCount));
+    jobs[t].n = n;
+    jobs[t].t = t;
+    jobs[t].inserted = jobs[t].deleted = 0;
+  }
+  mtRun (mtInsert,jobs);
+  for (t=0;t<MT_THREADS;t++)
+    inserted += jobs[t].inserted;
+  CHECK (inserted == n);
+  CHECK (hash_tableMTNumElem (table) == n);
+  for (kc.key=0;kc.key<n;kc.key++) {
+    if (!CHECK (hash_tableMTFind (table,&kc,(void **)&found)))
+      continue;
+    CHECK (found->key == kc.key);
+    CHECK (found->count == (kc.key < n / 4 ? MT_THREADS : 1));
+    for (t=0,owned=0;t<MT_THREADS;t++)
+      owned += found == &jobs[t].entries[kc.key];
+    CHECK (owned == 1);
+  }
+  kc.key = n;
+  CHECK (!hash_tableMTFind (table,&kc,(void **)&found));
+  mtRun (mtDelete,jobs);
+  for (t=0;t<MT_THREADS;t++)
+    deleted += jobs[t].deleted;
+  CHECK (deleted == n);
+  CHECK (hash_tableMTNumElem (table) == 0);
+  for (k=0;k<n;k+=n/16) {
+    kc.key = k;
+    CHECK (!hash_tableMTFind (table,&kc,(void **)&found));
+  }
+  hash_tableMTDestroy (table);
+  for (t=0;t<MT_THREADS;t++)
+    hlr_free (jobs[t].entries);
+  CHECK (hlr_getAllocCnt () == allocCnt);
+  return report ("hash_tableMT");
+}
+
+/* ------------------ array: parallel sort and uniq --------------------- */
+
+typedef struct {
+  int key; // first, so that orderInt() orders by key
+  int pos; // position before sorting
+}KeyPos;
+
+static int orderKeyPos (void *p1,void *p2)
+{
+  KeyPos *a = (KeyPos *)p1;
+  KeyPos *b = (KeyPos *)p2;
+
+  if (a->key != b->key)
+    return a->key < b->key ? -1 : 1;
+  return a->pos < b->pos ? -1 : a->pos > b->pos;
+}
+
+static int sameArray (Array a,Array b)
+{
+  return arrayMax (a) == arrayMax (b) &&
+    memcmp (arrp (a,0,char),arrp (b,0,char),
+            (size_t)arrayMax (a) * a->size) == 0;
+}
+
+static int checkArrayParallel (int n)
+{
+  /* arraySortParallel() and arrayUniqParallel() with several thread
+     counts against arraySort() and arrayUniq(); the Arrays have many
+     equal keys. Sorting by key only may order equal keys differently,
+     so that result is compared after sorting by key and position.
+     Threads are used from 50000 elements on */
+  int threads[] = {1,2,3,4,7,0};
+  int nt = sizeof (threads) / sizeof (threads[0]);
+  Array x = arrayCreate (n,KeyPos);
+  Array a,b,u,dups,bDups;
+  KeyPos sentinel = {-1,-1};
+  KeyPos *kp;
+  int size,t,i;
+
+  for (size=n;size<=n+12345;size+=12345) {
+    arrayClear (x);
+    for (i=0;i<size;i++) {
+      kp = arrayp (x,i,KeyPos);
+      kp->key = rand () % (size / 4 + 1);
+      kp->pos = i;
+    }
+    a = arrayCopy (x);
+    arraySort (a,orderKeyPos);
+    for (t=0;t<nt;t++) {
+      b = arrayCopy (x);
+      arraySortParallel (b,orderKeyPos,threads[t]);
+      CHECK (sameArray (a,b));
+      arrayDestroy (b);
+      b = arrayCopy (x);
+      arraySortParallel (b,orderInt,threads[t]);
+      for (i=1;i<size;i++)
+        if (!CHECK (arrp (b,i-1,KeyPos)->key <= arrp (b,i,KeyPos)->key))
+          break;
+      arraySort (b,orderKeyPos);
+      CHECK (sameArray (a,b));
+      arrayDestroy (b);
+    }
+    // uniq by key of the sorted input; duplicates are appended to b
+    u = arrayCopy (a);
+    dups = arrayCreate (10,KeyPos);
+    array (dups,0,KeyPos) = sentinel;
+    arrayUniq (u,dups,orderInt);
+    for (t=0;t<nt;t++) {
+      b = arrayCopy (a);
+      bDups = arrayCreate (10,KeyPos);
+      array (bDups,0,KeyPos) = sentinel;
+      arrayUniqParallel (b,bDups,orderInt,threads[t]);
+      CHECK (sameArray (u,b) && sameArray (dups,bDups));
+      arrayDestroy (bDups);
+      arrayDestroy (b);
+      b = arrayCopy (a);
+      arrayUniqParallel (b,NULL,orderInt,threads[t]);
+      CHECK (sameArray (u,b));
+      arrayDestroy (b);
+    }
+    arrayDestroy (dups);
+    arrayDestroy (u);
+    arrayDestroy (a);
+  }
+  arrayDestroy (x);
+  return report ("arrayPar");
+}
+
+/* ----------------------------- ls_parallelForLines ------------------- */
+
+/// most threads used by checkParallelLines()
+#define LS_THREADS 7
+
+typedef struct {
+  long lines[LS_THREADS]; // lines seen by each thread
+  long bytes[LS_THREADS]; // their total length
+  int bad[LS_THREADS]; // lines whose length was not lineLen
+}LineCounts;
+
+static void countLine (char *line,int lineLen,int thread,Stringa out,
+                       void *userdata)
+{
+  /* runs in several threads, so it only changes the counts of its own */
+  LineCounts *lc = (LineCounts *)userdata;
+
+  lc->lines[thread]++;
+  lc->bytes[thread] += lineLen;
+  lc->bad[thread] += strlen (line) != lineLen;
+  if (out != NULL) {
+    stringCat (out,line);
+    stringCat (out,"\n");
+  }
+}
+
+static int checkParallelLines (int n)
+{
+  /* writes a file of n lines of random length, some ending in \r\n,
+     the last one without \n; ls_parallelForLines() with several thread
+     counts must see the same number of lines as ls_nextLine() and, when
+     merging, write the lines in file order */
+  int threads[] = {1,2,4,LS_THREADS};
+  int nt = sizeof (threads) / sizeof (threads[0]);
+  Stringa fn = stringCreate (40);
+  Stringa expect = stringCreate (1000);
+  Stringa got = stringCreate (1000);
+  LineStream ls;
+  LineCounts lc;
+  FILE *fp,*out;
+  char buf[4096];
+  char *line;
+  long lines = 0,bytes = 0,sumLines,sumBytes;
+  int i,k,t,bad,len;
+
+  stringPrintf (fn,"/tmp/kerncheck%d.txt",(int)getpid ());
+  if ((fp = fopen (string (fn),"w")) == NULL)
+    die ("%s: cannot write",string (fn));
+  for (i=0;i<n;i++) {
+    fprintf (fp,"%d ",i);
+    for (k=rand ()%200;k>0;k--)
+      putc ('a' + rand () % 26,fp);
+    if (i < n - 1)
+      fputs (rand () % 10 ? "\n" : "\r\n",fp);
+  }
+  fclose (fp);
+  ls = ls_createFromFile (string (fn));
+  while ((line = ls_nextLine (ls)) != NULL) {
+    lines++;
+    bytes += strlen (line);
+    stringCat (expect,line);
+    stringCat (expect,"\n");
+  }
+  ls_destroy (ls);
+  CHECK (lines == n);
+  for (t=0;t<nt;t++) {
+    for (k=0;k<2;k++) { // without and with output
+      memset (&lc,0,sizeof (lc));
+      out = NULL;
+      if (k == 1 && (out = tmpfile ()) == NULL)
+        die ("cannot create a temporary file");
+      CHECK (ls_parallelForLines (string (fn),threads[t],countLine,&lc,
+                                  out) == lines);
+      sumLines = sumBytes = 0;
+      bad = 0;
+      for (i=0;i<LS_THREADS;i++) {
+        CHECK (i < threads[t] || lc.lines[i] == 0);
+        sumLines += lc.lines[i];
+        sumBytes += lc.bytes[i];
+        bad += lc.bad[i];
+      }
+      CHECK (sumLines == lines && sumBytes == bytes && bad == 0);
+      if (out == NULL)
+        continue;
+      rewind (out);
+      stringClear (got);
+      while ((len = fread (buf,1,sizeof (buf),out)) > 0)
+        stringNCat (got,buf,len);
+      fclose (out);
+      CHECK (stringLen (got) == stringLen (expect) &&
+             strEqual (string (got),string (expect)));
+    }
+  }
+  unlink (string (fn));
+  stringDestroy (got);
+  stringDestroy (expect);
+  stringDestroy (fn);
+  return report ("ls_parallel");
+}
+
+/* ------------------ statistics: order statistics ---------------------- */
+
+static int cmpDouble (const void *p1,const void *p2)
+{
+  double a = *(double *)p1;
+  double b = *(double *)p2;
+  return a < b ? -1 : a > b;
+}
+
+static int checkOrderStats (int n)
+{
+  /* the *P functions against their sorting counterparts, on random data
+     with many ties, alternately with and without scratch space */
+  double *x = (double *)hlr_malloc (n * sizeof (double));
+  double *a = (double *)hlr_malloc (n * sizeof (double));
+  double *b = (double *)hlr_malloc (n * sizeof (double));
+  double *c = (double *)hlr_malloc (n * sizeof (double));
+  Array scratch = arrayCreate (10,double);
+  Array sc;
+  int ranks[20];
+  double v[20];
+  double q25,q75,p25,p75,m,p;
+  int round,num,i;
+
+  for (round=0;round<2000;round++) {
+    num = 1 + rand () % MIN (n,round < 1000 ? 20 : 2000);
+    for (i=0;i<num;i++)
+      x[i] = rand () % (1 + num / 3) - num / 6 + (rand () % 2 ? 0.5 : 0.0);
+    memcpy (c,x,num * sizeof (double));
+    memcpy (a,x,num * sizeof (double));
+    sc = round % 2 ? scratch : NULL;
+    m = stat_median_quart (a,num,&q25,&q75); // sorts a
+    CHECK (stat_medianP (x,num,sc) == m);
+    CHECK (stat_median_quartP (x,num,&p25,&p75,sc) == m &&
+           p25 == q25 && p75 == q75);
+    for (i=0;i<20;i++)
+      ranks[i] = rand () % num;
+    stat_orderStats (x,num,ranks,20,v,sc);
+    for (i=0;i<20;i++)
+      CHECK (v[i] == a[ranks[i]]);
+    if (num > 1) {
+      p = 0.01 + (rand () % 9800) / 100.0;
+      memcpy (b,x,num * sizeof (double));
+      CHECK (stat_percentileP (x,num,p,sc) == stat_percentile (b,num,p));
+    }
+    for (i=0;i<num;i++)
+      b[i] = fabs (x[i] - m);
+    qsort (b,num,sizeof (double),cmpDouble);
+    memcpy (a,x,num * sizeof (double));
+    CHECK (stat_median_abs_devP (x,num,sc) == stat_median_abs_dev (a,num));
+    CHECK (stat_median_abs_devP (x,num,sc) ==
+           (num % 2 ? b[num/2] : 0.5 * (b[num/2-1] + b[num/2])));
+    if (num > 1) {
+      memcpy (a,x,num * sizeof (double));
+      CHECK (stat_ma68 (a,num) == stat_percentile (b,num,68.0));
+    }
+    CHECK (memcmp (x,c,num * sizeof (double)) == 0); // x is not changed
+  }
+  arrayDestroy (scratch);
+  hlr_free (c);
+  hlr_free (b);
+  hlr_free (a);
+  hlr_free (x);
+  return report ("stat_*P");
+}
+
+/* ------------------ statistics: StatAccum ----------------------------- */
+
+static int near (double a,double b)
+{
+  /* equal up to rounding errors */
+  return fabs (a - b) <= 1e-9 * MAX (1.0,MAX (fabs (a),fabs (b)));
+}
+
+static int checkAccum (int n)
+{
+  /* accumulators of random parts of the data, merged in random order,
+     against stat_mean(), stat_variance(), stat_skew() and stat_kurt() */
+  double *x = (double *)hlr_malloc (n * sizeof (double));
+  StatAccum parts[8];
+  StatAccum all;
+  double min,max;
+  int round,num,i,k,from,to;
+
+  for (round=0;round<200;round++) {
+    num = 4 + rand () % (round < 100 ? 50 : n - 3);
+    min = HUGE_VAL;
+    max = -HUGE_VAL;
+    // skewed values; no large offset, stat_variance() sums squares
+    for (i=0;i<num;i++) {
+      x[i] = (double)rand () / RAND_MAX;
+      x[i] = x[i] * x[i] * x[i] * (round % 2 ? 1.0 : -1.0);
+      min = MIN (min,x[i]);
+      max = MAX (max,x[i]);
+    }
+    for (k=0;k<8;k++)
+      stat_accumInit (&parts[k]);
+    for (from=0;from<num;from=to) { // some parts stay empty
+      to = from + 1 + rand () % (num / 3 + 1);
+      to = MIN (to,num);
+      k = rand () % 8;
+      if (rand () % 2)
+        stat_accumAddValues (&parts[k],x + from,to - from);
+      else
+        for (i=from;i<to;i++)
+          stat_accumAdd (&parts[k],x[i]);
+    }
+    for (k=7;k>0;k--) {
+      i = rand () % k;
+      stat_accumMerge (&parts[i],&parts[k]);
+    }
+    all = parts[0];
+    CHECK (all.n == num);
+    CHECK (stat_accumMin (&all) == min && stat_accumMax (&all) == max);
+    CHECK (near (stat_accumMean (&all),stat_mean (x,num)));
+    CHECK (near (stat_accumVariance (&all),stat_variance (x,num)));
+    CHECK (near (stat_accumSkew (&all),stat_skew (x,num)));
+    CHECK (near (stat_accumKurt (&all),stat_kurt (x,num)));
+  }
+  hlr_free (x);
+  return report ("StatAccum");
+}
+
+/* ------------------ statistics: StatSketch ---------------------------- */
+
+static double rankOf (double a[],int num,double v)
+{
+  /* fraction of the sorted values a[] not larger than v */
+  int lo = 0,hi = num,mid;
+
+  while (lo < hi) {
+    mid = lo + (hi - lo) / 2;
+    if (a[mid] <= v)
+      lo = mid + 1;
+    else
+      hi = mid;
+  }
+  return (double)lo / num;
+}
+
+static int checkSketch (int n)
+{
+  /* sketches of parts of the data, serialized one after the other,
+     deserialized and merged, against a sketch of all data and the
+     sorted data; then the exact quantiles of a few values */
+  double qs[] = {0.001,0.01,0.05,0.1,0.25,0.5,0.75,0.9,0.95,0.99,0.999};
+  int nq = sizeof (qs) / sizeof (qs[0]);
+  double *x = (double *)hlr_malloc (n * sizeof (double));
+  Array bytes = arrayCreate (1000,char);
+  int start[5];
+  StatSketch all,part,merged,copy;
+  double v;
+  int i,k,from,to;
+
+  for (i=0;i<n;i++) // heavy right tail
+    x[i] = exp (4.0 * rand () / RAND_MAX) * rand () / RAND_MAX;
+  all = stat_sketchCreate (100);
+  stat_sketchAddValues (all,x,n);
+  for (k=0,from=0;k<4;k++,from=to) {
+    to = k < 3 ? from + rand () % (n - from) : n;
+    part = stat_sketchCreate (100);
+    for (i=from;i<to;i++)
+      stat_sketchAdd (part,x[i]);
+    start[k] = arrayMax (bytes);
+    stat_sketchSerialize (part,bytes);
+    stat_sketchDestroy (part);
+  }
+  start[4] = arrayMax (bytes);
+  merged = stat_sketchCreate (100);
+  for (k=0;k<4;k++) {
+    CHECK (stat_sketchDeserialize (arrp (bytes,start[k],char),
+                                   start[k+1] - start[k] - 1) == NULL);
+    part = stat_sketchDeserialize (arrp (bytes,start[k],char),
+                                   start[4] - start[k]);
+    if (CHECK (part != NULL)) {
+      stat_sketchMerge (merged,part);
+      stat_sketchDestroy (part);
+    }
+  }
+  warnReset ();
+  arraySetMax (bytes,0);
+  stat_sketchSerialize (all,bytes);
+  copy = stat_sketchDeserialize (arrp (bytes,0,char),arrayMax (bytes));
+  qsort (x,n,sizeof (double),cmpDouble);
+  CHECK (stat_sketchCount (all) == n && stat_sketchCount (merged) == n);
+  CHECK (stat_sketchQuantile (all,0.0) == x[0] &&
+         stat_sketchQuantile (merged,0.0) == x[0]);
+  CHECK (stat_sketchQuantile (all,1.0) == x[n-1] &&
+         stat_sketchQuantile (merged,1.0) == x[n-1]);
+  for (i=0;i<nq;i++) {
+    v = stat_sketchQuantile (all,qs[i]);
+    CHECK (fabs (rankOf (x,n,v) - qs[i]) <= 0.01); // see stat_sketchCreate()
+    CHECK (copy != NULL && stat_sketchQuantile (copy,qs[i]) == v);
+    v = stat_sketchQuantile (merged,qs[i]);
+    CHECK (fabs (rankOf (x,n,v) - qs[i]) <= 0.01); // see stat_sketchCreate()
+  }
+  stat_sketchDestroy (copy);
+  stat_sketchDestroy (merged);
+  stat_sketchDestroy (all);
+  // few values: exact, interpolating between neighbors
+  all = stat_sketchCreate (100);
+  for (i=10;i>=0;i--)
+    stat_sketchAdd (all,i);
+  for (i=0;i<=10;i++)
+    CHECK (stat_sketchQuantile (all,i / 10.0) == i);
+  CHECK (near (stat_sketchQuantile (all,0.05),0.5));
+  stat_sketchDestroy (all);
+  arrayDestroy (bytes);
+  hlr_free (x);
+  return report ("StatSketch");
+}
+
+/* ------------------ statistics: quantile normalisation ---------------- */
+
+typedef struct {
+  double value;
+  int index; // position in the vector
+}IndexedValue;
+
+static int orderIndexedValue (const void *p1,const void *p2)
+{
+  /* by value, equal values by position */
+  const IndexedValue *a = (const IndexedValue *)p1;
+  const IndexedValue *b = (const IndexedValue *)p2;
+
+  if (a->value != b->value)
+    return a->value < b->value ? -1 : 1;
+  return a->index - b->index;
+}
+
+static void rankVector (double *x,int dim,IndexedValue *iv)
+{
+  /* iv: the components of x in increasing order */
+  int j;
+
+  for (j=0;j<dim;j++) {
+    iv[j].value = x[j];
+    iv[j].index = j;
+  }
+  qsort (iv,dim,sizeof (IndexedValue),orderIndexedValue);
+}
+
+static void qqSerial (double **x,int rows,int dim,double *values)
+{
+  /* stat_qq() as it was before it was parallelised: sort a copy of each
+     vector, average the i-th smallest components, write them back */
+  IndexedValue **iv = (IndexedValue **)hlr_malloc (rows * sizeof (IndexedValue *));
+  int i,j;
+
+  for (i=0;i<rows;i++) {
+    iv[i] = (IndexedValue *)hlr_malloc (dim * sizeof (IndexedValue));
+    rankVector (x[i],dim,iv[i]);
+  }
+  for (j=0;j<dim;j++) {
+    values[j] = 0.0;
+    for (i=0;i<rows;i++)
+      values[j] += iv[i][j].value;
+    values[j] /= rows;
+    for (i=0;i<rows;i++)
+      x[i][iv[i][j].index] = values[j];
+  }
+  for (i=0;i<rows;i++)
+    hlr_free (iv[i]);
+  hlr_free (iv);
+}
+
+static void qqFixedSerial (double **x,int rows,int dim,double *values)
+{
+  /* stat_qq_fixed() as it was before it was parallelised */
+  IndexedValue *iv = (IndexedValue *)hlr_malloc (dim * sizeof (IndexedValue));
+  int i,j;
+
+  for (i=0;i<rows;i++) {
+    rankVector (x[i],dim,iv);
+    for (j=0;j<dim;j++)
+      x[i][iv[j].index] = values[j];
+  }
+  hlr_free (iv);
+}
+
+static int checkQq (int n)
+{
+  /* stat_qq() and stat_qq_fixed() against the serial algorithm they
+     replaced, on a matrix large enough for threads and on small ones
+     with many ties, which must keep the order of their positions;
+     with threads the reference values may differ in the last bits */
+  double **x,**y,*values,*expect;
+  int round,rows,dim,i,j;
+
+  for (round=0;round<20;round++) {
+    rows = round == 0 ? 8 : 1 + rand () % 10;
+    dim = round == 0 ? n / 2 : 1 + rand () % 200;
+    x = (double **)hlr_malloc (rows * sizeof (double *));
+    y = (double **)hlr_malloc (rows * sizeof (double *));
+    for (i=0;i<rows;i++) {
+      x[i] = (double *)hlr_malloc (dim * sizeof (double));
+      y[i] = (double *)hlr_malloc (dim * sizeof (double));
+      for (j=0;j<dim;j++)
+        x[i][j] = y[i][j] = round % 2 ? rand () % 5 :
+          exp (8.0 * rand () / RAND_MAX);
+    }
+    values = (double *)hlr_malloc (dim * sizeof (double));
+    expect = (double *)hlr_malloc (dim * sizeof (double));
+    stat_qq (x,rows,dim,values);
+    qqSerial (y,rows,dim,expect);
+    for (j=0;j<dim;j++)
+      CHECK (near (values[j],expect[j]));
+    for (i=0;i<rows;i++)
+      for (j=0;j<dim;j++)
+        CHECK (near (x[i][j],y[i][j]));
+    for (i=0;i<rows;i++)
+      for (j=0;j<dim;j++)
+        x[i][j] = y[i][j] = round % 2 ? rand () % 5 : rand ();
+    stat_qq_fixed (x,rows,dim,expect);
+    qqFixedSerial (y,rows,dim,expect);
+    for (i=0;i<rows;i++)
+      CHECK (memcmp (x[i],y[i],dim * sizeof (double)) == 0);
+    for (i=0;i<rows;i++) {
+      hlr_free (y[i]);
+      hlr_free (x[i]);
+    }
+    hlr_free (expect);
+    hlr_free (values);
+    hlr_free (y);
+    hlr_free (x);
+  }
+  return report ("stat_qq");
+}
+
+int main (int argc,char *argv[])
+{
+  int n = 100000;
+  int seed = 1;
+  int ok = 1;
+
+  if (argc > 1) { // arg_init() shows the usage if there are no arguments
+    if (arg_init (argc,argv,"n,1 seed,1",NULL,usagef) != argc)
+      usage ("too many arguments");
+    if (arg_present ("n"))
+      n = MAX (16,atoi (arg_get ("n")));
+    if (arg_present ("seed"))
+      seed = atoi (arg_get ("seed"));
+  }
+  srand (seed);
+  ok &= checkOht (n);
+  ok &= checkBtree (n);
+  ok &= checkSst (n);
+  ok &= checkIntern (n);
+  ok &= checkHashMT (n);
+  ok &= checkArrayParallel (n);
+  ok &= checkParallelLines (n);
+  ok &= checkOrderStats (n);
+  ok &= checkAccum (n);
+  ok &= checkSketch (n);
+  ok &= checkQq (n);
+  return ok ? 0 : 1;
+}
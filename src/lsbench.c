@@ -0,0 +1,148 @@
+#include <math.h>
+#include <sys/time.h>
+#include "format.h"
+#include "log.h"
+#include "linestream.h"
+#include "arg.h"
+
+#define STARTUP_MSG "Line reading throughput of getLine() and LineStreams"
+#define PROG_VERSION "DEV"
+#define AUTHOR_MAIL "roland.schmucki@roche.com"
+
+
+void usagef (int level)
+{
+  romsg ("\n"
+         "Program: %s \n\n"
+         "Version: %s \n\n"
+         "Notes:   %s \n\n"
+         "Usage:   %s [-rounds n] file\n\n"
+         "Reads 'file' line by line with getLine() (the former engine of\n"
+         "ls_createFromFile), ls_createFromFile() and ls_createFromMmap()\n"
+         "(with ls_nextSpan() and with ls_nextLine()) and reports the\n"
+         "throughput of each in GB/s and the anonymous memory in use\n"
+         "at the end of reading (Linux only).\n"
+         "-rounds: repeat each measurement n times, report the best (3)\n"
+         "\n\n"
+         "Report bugs and feedback to %s"
+         "\n\n",
+         arg_getProgName (),PROG_VERSION,STARTUP_MSG,arg_getProgName (),
+         AUTHOR_MAIL);
+}
+
+static double now (void)
+{
+  struct timeval tv;
+  gettimeofday (&tv,NULL);
+  return tv.tv_sec + tv.tv_usec / 1e6;
+}
+
+static long anonKb (void)
+{
+  /* anonymous resident memory in kB, -1 if unknown */
+  FILE *fp;
+  char line[256];
+  long kb = -1;
+
+  if ((fp = fopen ("/proc/self/status","r")) == NULL)
+    return -1;
+  while (fgets (line,sizeof (line),fp) != NULL)
+    if (strncmp (line,"RssAnon:",8) == 0)
+      kb = atol (line + 8);
+  fclose (fp);
+  return kb;
+}
+
+static double benchGetLine (char *fn,long *bytes,long *lines)
+{
+  FILE *fp;
+  char *line = NULL;
+  int buflen;
+  int len;
+  double t = now ();
+
+  if ((fp = fopen (fn,"r")) == NULL)
+    die ("%s: cannot open",fn);
+  while ((len = getLine (fp,&line,&buflen)) > 0) {
+    *bytes += len;
+    (*lines)++;
+  }
+  fclose (fp);
+  hlr_free (line);
+  return now () - t;
+}
+
+static double benchLineStream (char *fn,int useMmap,int useSpan,
+                               long *bytes,long *lines,long *kb)
+{
+  LineStream ls;
+  char *line;
+  int len;
+  long kb0 = anonKb ();
+  double t = now ();
+
+  *kb = 0;
+  ls = useMmap ? ls_createFromMmap (fn) : ls_createFromFile (fn);
+  if (ls == NULL)
+    die ("%s",warnReport ());
+  for (;;) {
+    if (useSpan)
+      line = ls_nextSpan (ls,&len);
+    else if ((line = ls_nextLine (ls)) != NULL)
+      len = strlen (line);
+    if (line == NULL)
+      break;
+    *bytes += len + 1;
+    (*lines)++;
+    // peak growth of anonymous memory while reading, sampled
+    if (kb0 >= 0 && (*lines & 0xffff) == 0)
+      *kb = MAX (*kb,anonKb () - kb0);
+  }
+  if (kb0 < 0)
+    *kb = -1;
+  ls_destroy (ls);
+  return now () - t;
+}
+
+static void report (char *what,double secs,long bytes,long lines,long kb)
+{
+  printf ("%-24s %10ld lines %8.3f s %8.3f GB/s",
+          what,lines,secs,secs > 0 ? bytes / secs / 1e9 : 0.0);
+  if (kb >= 0)
+    printf (" %10ld kB anon",kb);
+  printf ("\n");
+}
+
+int main (int argc,char *argv[])
+{
+  char *fn;
+  int rounds = 3;
+  int r,k;
+  long bytes = 0;
+  long lines = 0;
+  long kb = -1;
+  double secs,best;
+  char *names[4] = {"getLine (FILE*)","ls_createFromFile",
+                    "ls_createFromMmap span","ls_createFromMmap line"};
+
+  if (arg_init (argc,argv,"rounds,1","file",usagef) != argc)
+    usage ("too many arguments");
+  fn = arg_get ("file");
+  if (arg_present ("rounds"))
+    rounds = MAX (1,atoi (arg_get ("rounds")));
+  for (k=0;k<4;k++) {
+    best = HUGE_VAL;
+    for (r=0;r<rounds;r++) {
+      bytes = lines = 0;
+      kb = -1;
+      if (k == 0)
+        secs = benchGetLine (fn,&bytes,&lines);
+      else
+        secs = benchLineStream (fn,k >= 2,k != 3,&bytes,&lines,&kb);
+      if (secs < best)
+        best = secs;
+    }
+    report (names[k],best,bytes,lines,kb);
+  }
+  return 0;
+}